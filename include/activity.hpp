@@ -0,0 +1,24 @@
+#ifndef ACTIVITY_HPP
+#define ACTIVITY_HPP
+
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+#include "gates.hpp"
+
+//----------------------------------------------------------------------------------------------------------------------
+//Result of a switching activity analysis: how many times the output of every gate (indexed by uid) toggles between two
+//consecutive input vectors, and the totals for every layer and every type of gate. Since the dynamic power of a gate is
+//roughly proportional to how often its output switches, they're a proxy for where the power is dissipated
+struct switching_activity_report{
+    size_t num_vectors = 0;
+    uint64_t total_toggles = 0;
+    std::map<size_t, uint64_t> gate_toggles;
+    std::map<size_t, uint64_t> layer_toggles;
+    std::map<gate_type, uint64_t> type_toggles;
+
+    double toggles_per_transition(const uint64_t& toggles) const {return num_vectors < 2 ? 0.0 : double(toggles) / (num_vectors - 1);}
+};
+
+#endif
@@ -0,0 +1,387 @@
+#include "aig.hpp"
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+//Truth tables of the variables of a function of AIG_CUT_SIZE variables
+static const uint32_t var_truths[AIG_CUT_SIZE] = {0xAAAA, 0xCCCC, 0xF0F0, 0xFF00};
+static const uint32_t full_truth = 0xFFFF;
+
+//Functions to get the negative and positive cofactors of a truth table with respect to variable v, as truth tables
+//which don't depend on v
+static uint32_t cofactor0(const uint32_t& t, const size_t& v){
+    const uint32_t half = t & ~var_truths[v] & full_truth;
+    return half | (half << (1 << v));
+}
+
+static uint32_t cofactor1(const uint32_t& t, const size_t& v){
+    const uint32_t half = t & var_truths[v];
+    return half | (half >> (1 << v));
+}
+
+//Function to compute an irredundant sum of products of a function, with the Minato-Morreale algorithm, covering all
+//the minterms of on and no minterm outside ondc, using only the first num_vars variables.
+//Every cube is appended to cubes as a bitmask with bit 2 * v set for the literal v, and bit 2 * v + 1 set for the literal
+//not v (a cube without literals is the constant 1). Returns the truth table of the cover
+static uint32_t isop(const uint32_t& on, const uint32_t& ondc, const size_t& num_vars, vector<uint8_t>& cubes){
+    if(on == 0)
+        return 0;
+    if(ondc == full_truth){
+        cubes.push_back(0);
+        return full_truth;
+    }
+
+    //Split on the topmost variable the function depends on
+    size_t v = num_vars - 1;
+    while(cofactor0(on, v) == cofactor1(on, v) && cofactor0(ondc, v) == cofactor1(ondc, v))
+        --v;
+
+    const uint32_t on0 = cofactor0(on, v);
+    const uint32_t on1 = cofactor1(on, v);
+    const uint32_t ondc0 = cofactor0(ondc, v);
+    const uint32_t ondc1 = cofactor1(ondc, v);
+
+    const size_t first_cube0 = cubes.size();
+    const uint32_t cover0 = isop(on0 & ~ondc1 & full_truth, ondc0, v, cubes);
+    for(size_t c = first_cube0; c < cubes.size(); ++c)
+        cubes[c] |= (1 << (2 * v + 1));
+
+    const size_t first_cube1 = cubes.size();
+    const uint32_t cover1 = isop(on1 & ~ondc0 & full_truth, ondc1, v, cubes);
+    for(size_t c = first_cube1; c < cubes.size(); ++c)
+        cubes[c] |= (1 << (2 * v));
+
+    const uint32_t cover_rest = isop((on0 & ~cover0) | (on1 & ~cover1), ondc0 & ondc1, v, cubes);
+
+    return ((cover0 & ~var_truths[v]) | (cover1 & var_truths[v]) | cover_rest) & full_truth;
+}
+
+//Function to count the AND nodes needed to build a sum of products, without considering any sharing
+static size_t sop_cost(const vector<uint8_t>& cubes){
+    if(cubes.empty())
+        return 0;
+
+    size_t cost = cubes.size() - 1;
+    for(const auto& c : cubes){
+        const size_t num_literals = __builtin_popcount(c);
+        if(num_literals > 0)
+            cost += num_literals - 1;
+    }
+
+    return cost;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//Private members
+
+//Function to enumerate, for every node, the trivial cut made of the node itself followed by at most
+//AIG_MAX_CUTS_PER_NODE cuts of at most AIG_CUT_SIZE leaves, with the function of the node over them. The cuts of an AND
+//node are the unions of a cut of each of its fanins, dropping those which contain another one, and keeping the smallest
+void aig::enumerate_cuts(vector<vector<cut>>& cuts) const {
+    cuts.assign(num_nodes(), vector<cut>());
+
+    //Union of the sorted leaves of two cuts, failing if it has more than AIG_CUT_SIZE leaves
+    auto merge_cuts = [](const cut& a, const cut& b, cut& merged){
+        size_t i = 0;
+        size_t j = 0;
+        merged.m_num_leaves = 0;
+        while(i < a.m_num_leaves || j < b.m_num_leaves){
+            uint32_t leaf;
+            if(j == b.m_num_leaves || (i < a.m_num_leaves && a.m_leaves[i] < b.m_leaves[j]))
+                leaf = a.m_leaves[i++];
+            else if(i == a.m_num_leaves || b.m_leaves[j] < a.m_leaves[i])
+                leaf = b.m_leaves[j++];
+            else {
+                leaf = a.m_leaves[i++];
+                ++j;
+            }
+
+            if(merged.m_num_leaves == AIG_CUT_SIZE)
+                return false;
+            merged.m_leaves[merged.m_num_leaves++] = leaf;
+        }
+
+        return true;
+    };
+
+    //Function of a cut over the leaves of a larger cut which contains them
+    auto expand_truth = [](const cut& c, const cut& larger){
+        size_t positions[AIG_CUT_SIZE];
+        for(size_t i = 0, j = 0; i < c.m_num_leaves; ++i){
+            while(larger.m_leaves[j] != c.m_leaves[i])
+                ++j;
+            positions[i] = j;
+        }
+
+        uint32_t truth = 0;
+        for(uint32_t m = 0; m < (1 << AIG_CUT_SIZE); ++m){
+            uint32_t sub_m = 0;
+            for(size_t i = 0; i < c.m_num_leaves; ++i)
+                sub_m |= ((m >> positions[i]) & 1) << i;
+            truth |= ((c.m_truth >> sub_m) & 1) << m;
+        }
+
+        return truth;
+    };
+
+    for(uint32_t node = 1; node < num_nodes(); ++node){
+        cut trivial_cut;
+        trivial_cut.m_leaves[0] = node;
+        trivial_cut.m_num_leaves = 1;
+        trivial_cut.m_truth = var_truths[0];
+        cuts[node].push_back(trivial_cut);
+
+        if(!is_and(node))
+            continue;
+
+        const uint32_t lits[2] = {m_fanin0[node], m_fanin1[node]};
+        vector<cut> candidates;
+        for(const auto& c0 : cuts[lit_node(lits[0])]){
+            for(const auto& c1 : cuts[lit_node(lits[1])]){
+                cut merged;
+                if(!merge_cuts(c0, c1, merged))
+                    continue;
+
+                const uint32_t truth0 = expand_truth(c0, merged) ^ (lit_inv(lits[0]) ? full_truth : 0);
+                const uint32_t truth1 = expand_truth(c1, merged) ^ (lit_inv(lits[1]) ? full_truth : 0);
+                merged.m_truth = truth0 & truth1;
+
+                candidates.push_back(merged);
+            }
+        }
+
+        //The smallest cuts first, so that the cuts containing another one can be dropped with a single pass
+        stable_sort(candidates.begin(), candidates.end(), [](const cut& a, const cut& b){return a.m_num_leaves < b.m_num_leaves;});
+        for(const auto& c : candidates){
+            if(cuts[node].size() > AIG_MAX_CUTS_PER_NODE)
+                break;
+
+            const bool dominated = any_of(cuts[node].begin() + 1, cuts[node].end(), [&c](const cut& other){
+                return includes(c.m_leaves, c.m_leaves + c.m_num_leaves, other.m_leaves, other.m_leaves + other.m_num_leaves);
+            });
+            if(!dominated)
+                cuts[node].push_back(c);
+        }
+    }
+}
+
+//Function to count the AND nodes that would be left unused by replacing a node with a new implementation over the
+//leaves of a cut: the nodes of its maximum fanout-free cone, bounded by the leaves. The references to the nodes are
+//temporarily removed and then restored
+size_t aig::mffc_size(const uint32_t& node, const cut& c, vector<uint32_t>& refs) const {
+    auto is_leaf = [&c](const uint32_t& n){return find(c.m_leaves, c.m_leaves + c.m_num_leaves, n) != c.m_leaves + c.m_num_leaves;};
+
+    size_t size = 0;
+    vector<uint32_t> to_visit = {node};
+    vector<uint32_t> visited;
+    while(!to_visit.empty()){
+        const uint32_t n = to_visit.back();
+        to_visit.pop_back();
+        ++size;
+
+        for(const auto& lit : {m_fanin0[n], m_fanin1[n]}){
+            const uint32_t fanin = lit_node(lit);
+            if(!is_and(fanin) || is_leaf(fanin))
+                continue;
+
+            visited.push_back(fanin);
+            if(--refs[fanin] == 0)
+                to_visit.push_back(fanin);
+        }
+    }
+
+    for(const auto& n : visited)
+        ++refs[n];
+
+    return size;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//Public members
+
+aig::aig(const size_t& num_inputs) :
+    m_num_inputs(num_inputs),
+    m_fanin0(num_inputs + 1, 0),
+    m_fanin1(num_inputs + 1, 0)
+{}
+
+//Function to get the literal of the AND of two literals, creating its node only if it doesn't exist yet and it isn't
+//trivial
+uint32_t aig::make_and(uint32_t a, uint32_t b){
+    if(a > b)
+        swap(a, b);
+
+    if(a == AIG_FALSE || a == lit_not(b))
+        return AIG_FALSE;
+    if(a == AIG_TRUE || a == b)
+        return b;
+
+    const uint64_t key = strash_key(a, b);
+    const auto it = m_strash.find(key);
+    if(it != m_strash.end())
+        return make_lit(it->second, false);
+
+    const uint32_t node = m_fanin0.size();
+    m_fanin0.push_back(a);
+    m_fanin1.push_back(b);
+    m_strash.emplace(key, node);
+
+    return make_lit(node, false);
+}
+
+//Function to get the literal of the exclusive or of two literals, made of three AND nodes
+uint32_t aig::make_xor(const uint32_t& a, const uint32_t& b){
+    return make_or(make_and(a, lit_not(b)), make_and(lit_not(a), b));
+}
+
+//Function to compute the level of every node, i.e. the length of the longest path from the inputs to it.
+//Returns the depth of the graph, the highest level of the nodes driving the outputs
+size_t aig::levels(vector<uint32_t>& node_levels) const {
+    node_levels.assign(num_nodes(), 0);
+    for(uint32_t node = m_num_inputs + 1; node < num_nodes(); ++node)
+        node_levels[node] = 1 + max(node_levels[lit_node(m_fanin0[node])], node_levels[lit_node(m_fanin1[node])]);
+
+    size_t depth = 0;
+    for(const auto& lit : m_outputs)
+        depth = max<size_t>(depth, node_levels[lit_node(lit)]);
+
+    return depth;
+}
+
+//Function to remove the AND nodes that don't reach any output, renumbering the others
+void aig::cleanup(){
+    vector<uint8_t> used(num_nodes(), false);
+    for(const auto& lit : m_outputs)
+        used[lit_node(lit)] = true;
+
+    for(uint32_t node = num_nodes(); node-- > m_num_inputs + 1;){
+        if(used[node]){
+            used[lit_node(m_fanin0[node])] = true;
+            used[lit_node(m_fanin1[node])] = true;
+        }
+    }
+
+    aig cleaned(m_num_inputs);
+    vector<uint32_t> new_lits(num_nodes());
+    for(uint32_t node = 0; node <= m_num_inputs; ++node)
+        new_lits[node] = make_lit(node, false);
+
+    auto translate = [&new_lits](const uint32_t& lit){return new_lits[lit_node(lit)] ^ lit_inv(lit);};
+    for(uint32_t node = m_num_inputs + 1; node < num_nodes(); ++node){
+        if(used[node])
+            new_lits[node] = cleaned.make_and(translate(m_fanin0[node]), translate(m_fanin1[node]));
+    }
+
+    for(const auto& lit : m_outputs)
+        cleaned.add_output(translate(lit));
+
+    *this = move(cleaned);
+}
+
+//Function to run a pass of cut-based local rewriting: for every AND node, every cut of at most AIG_CUT_SIZE leaves is
+//resynthesized from the irredundant sum of products of the node's function over the leaves (or of its inverse), and the
+//node is replaced by the implementation saving the most nodes, if any, compared with the nodes left unused by the
+//replacement. The graph is then rebuilt with the replacements, and kept only if it's actually smaller, since the
+//savings of overlapping replacements are estimated independently.
+//Returns true if the graph has been made smaller
+bool aig::rewrite(){
+    vector<vector<cut>> cuts;
+    enumerate_cuts(cuts);
+
+    vector<uint32_t> refs(num_nodes(), 0);
+    for(uint32_t node = m_num_inputs + 1; node < num_nodes(); ++node){
+        ++refs[lit_node(m_fanin0[node])];
+        ++refs[lit_node(m_fanin1[node])];
+    }
+    for(const auto& lit : m_outputs)
+        ++refs[lit_node(lit)];
+
+    struct replacement{
+        size_t m_cut;
+        bool m_inv;
+        vector<uint8_t> m_cubes;
+    };
+
+    vector<replacement> replacements(num_nodes(), replacement{0, false, {}});
+    bool any_replacement = false;
+    for(uint32_t node = m_num_inputs + 1; node < num_nodes(); ++node){
+        if(refs[node] == 0)
+            continue;
+
+        size_t best_gain = 0;
+        for(size_t c = 1; c < cuts[node].size(); ++c){
+            const size_t num_removed = mffc_size(node, cuts[node][c], refs);
+
+            for(const auto& inv : {false, true}){
+                const uint32_t truth = (inv ? ~cuts[node][c].m_truth & full_truth : cuts[node][c].m_truth);
+                vector<uint8_t> cubes;
+                isop(truth, truth, AIG_CUT_SIZE, cubes);
+
+                const size_t cost = sop_cost(cubes);
+                if(cost < num_removed && num_removed - cost > best_gain){
+                    best_gain = num_removed - cost;
+                    replacements[node] = replacement{c, inv, move(cubes)};
+                    any_replacement = true;
+                }
+            }
+        }
+    }
+
+    if(!any_replacement)
+        return false;
+
+    aig rewritten(m_num_inputs);
+    vector<uint32_t> new_lits(num_nodes());
+    for(uint32_t node = 0; node <= m_num_inputs; ++node)
+        new_lits[node] = make_lit(node, false);
+
+    auto translate = [&new_lits](const uint32_t& lit){return new_lits[lit_node(lit)] ^ lit_inv(lit);};
+    for(uint32_t node = m_num_inputs + 1; node < num_nodes(); ++node){
+        const replacement& r = replacements[node];
+        if(r.m_cut == 0){
+            new_lits[node] = rewritten.make_and(translate(m_fanin0[node]), translate(m_fanin1[node]));
+            continue;
+        }
+
+        const cut& c = cuts[node][r.m_cut];
+        uint32_t sum = AIG_FALSE;
+        for(const auto& cube : r.m_cubes){
+            uint32_t product = AIG_TRUE;
+            for(size_t v = 0; v < c.m_num_leaves; ++v){
+                const uint32_t leaf = new_lits[c.m_leaves[v]];
+                if(cube & (1 << (2 * v)))
+                    product = rewritten.make_and(product, leaf);
+                if(cube & (1 << (2 * v + 1)))
+                    product = rewritten.make_and(product, lit_not(leaf));
+            }
+            sum = rewritten.make_or(sum, product);
+        }
+
+        new_lits[node] = sum ^ r.m_inv;
+    }
+
+    for(const auto& lit : m_outputs)
+        rewritten.add_output(translate(lit));
+
+    rewritten.cleanup();
+    if(rewritten.num_ands() >= num_ands())
+        return false;
+
+    *this = move(rewritten);
+    return true;
+}
+
+//Function to remove the unused nodes and rewrite the graph until it stops getting smaller, or for at most
+//AIG_MAX_REWRITE_PASSES passes
+void aig::optimize(){
+    cleanup();
+
+    for(size_t pass = 0; pass < AIG_MAX_REWRITE_PASSES; ++pass){
+        if(!rewrite())
+            break;
+    }
+}
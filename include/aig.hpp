@@ -0,0 +1,69 @@
+#ifndef AIG_HPP
+#define AIG_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+#define AIG_FALSE 0
+#define AIG_TRUE 1
+#define AIG_CUT_SIZE 4                              //Maximum number of leaves of the cuts used for rewriting
+#define AIG_MAX_CUTS_PER_NODE 8                     //Cuts kept for every node, besides the trivial one
+#define AIG_MAX_REWRITE_PASSES 8                    //Passes of rewrite after which optimize stops anyway
+
+//----------------------------------------------------------------------------------------------------------------------
+//And-inverter graph: a combinational circuit made only of 2-input AND nodes, whose inputs and outputs can be inverted.
+//The nodes are referenced by literals: literal 2 * n is node n and literal 2 * n + 1 is its inverse. Node 0 is the
+//constant 0 (so the literals AIG_FALSE and AIG_TRUE are the constants), nodes 1 up to the number of inputs are the
+//inputs, and the AND nodes follow, each after the nodes it reads, so the nodes are always topologically ordered.
+//The AND nodes are structurally hashed: two nodes never read the same pair of literals, and the trivial ANDs (with a
+//constant, or with the same literal twice) are never created
+class aig{
+    private:
+        struct cut{
+            uint32_t m_leaves[AIG_CUT_SIZE];
+            uint8_t m_num_leaves;
+            uint16_t m_truth;                       //Function of the node over the leaves, leaf i being variable i
+        };
+
+        size_t m_num_inputs;
+        std::vector<uint32_t> m_fanin0;             //Literals read by each node, 0 for the constant and the inputs
+        std::vector<uint32_t> m_fanin1;
+        std::unordered_map<uint64_t, uint32_t> m_strash;
+        std::vector<uint32_t> m_outputs;
+
+        static uint64_t strash_key(const uint32_t& a, const uint32_t& b) {return (uint64_t(a) << 32) | b;}
+
+        void enumerate_cuts(std::vector<std::vector<cut>>& cuts) const;
+        size_t mffc_size(const uint32_t& node, const cut& c, std::vector<uint32_t>& refs) const;
+
+    public:
+        aig(const size_t& num_inputs);
+
+        static uint32_t lit_node(const uint32_t& lit) {return lit >> 1;}
+        static bool lit_inv(const uint32_t& lit) {return lit & 1;}
+        static uint32_t lit_not(const uint32_t& lit) {return lit ^ 1;}
+        static uint32_t make_lit(const uint32_t& node, const bool& inv) {return 2 * node + inv;}
+
+        size_t num_inputs() const {return m_num_inputs;}
+        size_t num_nodes() const {return m_fanin0.size();}
+        size_t num_ands() const {return m_fanin0.size() - m_num_inputs - 1;}
+        bool is_and(const uint32_t& node) const {return node > m_num_inputs;}
+        uint32_t fanin0(const uint32_t& node) const {return m_fanin0[node];}
+        uint32_t fanin1(const uint32_t& node) const {return m_fanin1[node];}
+        const std::vector<uint32_t>& outputs() const {return m_outputs;}
+
+        uint32_t input(const size_t& i) const {return make_lit(i + 1, false);}
+        uint32_t make_and(uint32_t a, uint32_t b);
+        uint32_t make_or(const uint32_t& a, const uint32_t& b) {return lit_not(make_and(lit_not(a), lit_not(b)));}
+        uint32_t make_xor(const uint32_t& a, const uint32_t& b);
+        void add_output(const uint32_t& lit) {m_outputs.push_back(lit);}
+
+        size_t levels(std::vector<uint32_t>& node_levels) const;
+        void cleanup();
+        bool rewrite();
+        void optimize();
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef ASYNC_WRITER_HPP
+#define ASYNC_WRITER_HPP
+
+#include <iostream>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+#include <cstddef>
+
+#define ASYNC_WRITER_MAX_QUEUED_BUFFERS 4           //Buffers waiting to be written before the producers get blocked
+
+//----------------------------------------------------------------------------------------------------------------------
+//Writer that moves the output of the simulations on a dedicated thread, so that computing the next results overlaps
+//with writing the previous ones.
+//The producers hand over whole buffers (std::string, std::vector<uint64_t>, ...), which are written in the same order
+//they have been handed over. When max_queued_buffers buffers are waiting to be written, the producers are blocked until
+//one of them is written, so the memory used stays bounded even if the ostream is slow. The buffers already written
+//are given back by get_buffer, to avoid allocating new ones
+template<typename buffer_t>
+class async_writer{
+    private:
+        std::ostream& m_os;
+        const size_t m_max_queued_buffers;
+        std::deque<buffer_t> m_queued_buffers;
+        std::vector<buffer_t> m_free_buffers;
+        bool m_closing;
+        std::mutex m_mutex;
+        std::condition_variable m_buffer_queued;
+        std::condition_variable m_buffer_written;
+        std::thread m_thread;
+
+        //Function executed by the writer thread
+        void run(){
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            while(true){
+                m_buffer_queued.wait(lock, [this](){return m_closing || !m_queued_buffers.empty();});
+                if(m_queued_buffers.empty())
+                    break;
+
+                buffer_t buffer = std::move(m_queued_buffers.front());
+                m_queued_buffers.pop_front();
+
+                lock.unlock();
+                m_os.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(*buffer.data()));
+                lock.lock();
+
+                m_free_buffers.push_back(std::move(buffer));
+                m_buffer_written.notify_all();
+            }
+
+            m_os.flush();
+        }
+
+    public:
+        async_writer(std::ostream& os, const size_t& max_queued_buffers = ASYNC_WRITER_MAX_QUEUED_BUFFERS) :
+            m_os(os),
+            m_max_queued_buffers(max_queued_buffers == 0 ? 1 : max_queued_buffers),
+            m_closing(false),
+            m_thread(&async_writer::run, this)
+        {}
+        ~async_writer() {close();}
+
+        async_writer(const async_writer&) = delete;
+        async_writer& operator=(const async_writer&) = delete;
+
+        //Function to get a buffer to fill, recycled from the ones already written if possible. Its contents are
+        //the ones it had when it was written, and it's up to the caller to clear or overwrite them
+        buffer_t get_buffer(){
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if(m_free_buffers.empty())
+                return buffer_t();
+
+            buffer_t buffer = std::move(m_free_buffers.back());
+            m_free_buffers.pop_back();
+            return buffer;
+        }
+
+        //Function to queue a buffer to be written, waiting if there are already too many buffers queued
+        void write(buffer_t&& buffer){
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_buffer_written.wait(lock, [this](){return m_queued_buffers.size() < m_max_queued_buffers;});
+            m_queued_buffers.push_back(std::move(buffer));
+            m_buffer_queued.notify_one();
+        }
+
+        //Function to wait for all the buffers queued to be written, and stop the writer thread. The ostream is flushed
+        void close(){
+            if(!m_thread.joinable())
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_closing = true;
+            }
+            m_buffer_queued.notify_one();
+            m_thread.join();
+        }
+};
+
+#endif
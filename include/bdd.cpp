@@ -0,0 +1,338 @@
+#include "bdd.hpp"
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+using namespace std;
+
+//The variable of the nodes in the free list, and of the terminal nodes
+static const uint32_t NO_VAR = UINT32_MAX;
+
+//----------------------------------------------------------------------------------------------------------------------
+//Private members
+
+//Function to get the node with the specified variable and children, creating it if it doesn't exist yet.
+//The children get referenced by the new node, while the node itself isn't referenced
+uint32_t bdd_manager::make_node(const uint32_t& var, const uint32_t& low, const uint32_t& high){
+    if(low == high)
+        return low;
+
+    const uint64_t key = unique_key(low, high);
+    const auto it = m_unique[var].find(key);
+    if(it != m_unique[var].end())
+        return it->second;
+
+    //While reordering the nodes can't be refused, since the BDDs would be left inconsistent
+    if(m_num_live_nodes >= m_max_nodes && !m_reordering){
+        m_overflow = true;
+        return BDD_FALSE;
+    }
+
+    uint32_t f;
+    if(!m_free_nodes.empty()){
+        f = m_free_nodes.back();
+        m_free_nodes.pop_back();
+    }
+    else {
+        f = m_nodes.size();
+        m_nodes.emplace_back();
+    }
+
+    m_nodes[f] = bdd_node{var, low, high, 0};
+    ++m_nodes[low].ref;
+    ++m_nodes[high].ref;
+    m_unique[var].emplace(key, f);
+    ++m_num_live_nodes;
+
+    return f;
+}
+
+//Function to delete a node which isn't referenced anymore, and all its descendants which aren't referenced anymore
+//after it's deleted
+void bdd_manager::delete_dead_node(const uint32_t& f){
+    vector<uint32_t> dead_nodes = {f};
+
+    while(!dead_nodes.empty()){
+        const uint32_t n = dead_nodes.back();
+        const bdd_node node = m_nodes[n];
+        dead_nodes.pop_back();
+
+        m_unique[node.var].erase(unique_key(node.low, node.high));
+        m_nodes[n].var = NO_VAR;
+        m_free_nodes.push_back(n);
+        --m_num_live_nodes;
+
+        for(const auto& child : {node.low, node.high}){
+            if(child > BDD_TRUE && --m_nodes[child].ref == 0)
+                dead_nodes.push_back(child);
+        }
+    }
+}
+
+//Function to swap the variables at level l and l + 1. The nodes of the upper variable x that depend on the lower
+//variable y are rewritten in place as nodes of y, whose children are (possibly new) nodes of x, so that every node keeps
+//representing the same function. The nodes of y that aren't referenced anymore are deleted
+void bdd_manager::swap_levels(const size_t& l){
+    const uint32_t x = m_level_to_var[l];
+    const uint32_t y = m_level_to_var[l + 1];
+
+    vector<uint32_t> moved_nodes;
+    for(const auto& p : m_unique[x]){
+        const bdd_node& node = m_nodes[p.second];
+        if(m_nodes[node.low].var == y || m_nodes[node.high].var == y)
+            moved_nodes.push_back(p.second);
+    }
+
+    for(const auto& f : moved_nodes)
+        m_unique[x].erase(unique_key(m_nodes[f].low, m_nodes[f].high));
+
+    for(const auto& f : moved_nodes){
+        const uint32_t f0 = m_nodes[f].low;
+        const uint32_t f1 = m_nodes[f].high;
+        const bool f0_on_y = (m_nodes[f0].var == y);
+        const bool f1_on_y = (m_nodes[f1].var == y);
+        const uint32_t f00 = (f0_on_y ? m_nodes[f0].low : f0);
+        const uint32_t f01 = (f0_on_y ? m_nodes[f0].high : f0);
+        const uint32_t f10 = (f1_on_y ? m_nodes[f1].low : f1);
+        const uint32_t f11 = (f1_on_y ? m_nodes[f1].high : f1);
+
+        const uint32_t g0 = make_node(x, f00, f10);
+        const uint32_t g1 = make_node(x, f01, f11);
+        ++m_nodes[g0].ref;
+        ++m_nodes[g1].ref;
+
+        m_nodes[f].var = y;
+        m_nodes[f].low = g0;
+        m_nodes[f].high = g1;
+        m_unique[y].emplace(unique_key(g0, g1), f);
+
+        for(const auto& old_child : {f0, f1}){
+            if(old_child > BDD_TRUE && --m_nodes[old_child].ref == 0)
+                delete_dead_node(old_child);
+        }
+    }
+
+    swap(m_level_to_var[l], m_level_to_var[l + 1]);
+    m_var_to_level[x] = l + 1;
+    m_var_to_level[y] = l;
+}
+
+//Function to move a variable through all the levels, and then leave it at the level where the BDDs were the smallest.
+//The variable is first moved towards the nearest end, and a direction is abandoned as soon as the BDDs grow more than
+//BDD_SIFTING_MAX_GROWTH times the smallest size found
+void bdd_manager::sift_var(const size_t& var){
+    size_t current_level = m_var_to_level[var];
+    size_t best_level = current_level;
+    size_t best_size = m_num_live_nodes;
+
+    auto move_down = [&](){
+        while(current_level + 1 < m_num_vars){
+            swap_levels(current_level++);
+            if(m_num_live_nodes < best_size){
+                best_size = m_num_live_nodes;
+                best_level = current_level;
+            }
+            else if(m_num_live_nodes > best_size * BDD_SIFTING_MAX_GROWTH)
+                break;
+        }
+    };
+    auto move_up = [&](){
+        while(current_level > 0){
+            swap_levels(--current_level);
+            if(m_num_live_nodes < best_size){
+                best_size = m_num_live_nodes;
+                best_level = current_level;
+            }
+            else if(m_num_live_nodes > best_size * BDD_SIFTING_MAX_GROWTH)
+                break;
+        }
+    };
+
+    if(current_level < m_num_vars / 2){
+        move_up();
+        move_down();
+    }
+    else {
+        move_down();
+        move_up();
+    }
+
+    while(current_level < best_level)
+        swap_levels(current_level++);
+    while(current_level > best_level)
+        swap_levels(--current_level);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//Public members
+
+bdd_manager::bdd_manager(const size_t& num_vars, const size_t& max_nodes) :
+    m_num_vars(num_vars),
+    m_max_nodes(max_nodes),
+    m_nodes(2, bdd_node{NO_VAR, 0, 0, 0}),
+    m_unique(num_vars),
+    m_cache(BDD_CACHE_SIZE, cache_entry{0, 0, 0, 0}),
+    m_var_to_level(num_vars),
+    m_level_to_var(num_vars),
+    m_num_live_nodes(0),
+    m_overflow(false),
+    m_reordering(false)
+{
+    //The terminal nodes are their own children, and they're never deleted
+    m_nodes[BDD_TRUE] = bdd_node{NO_VAR, BDD_TRUE, BDD_TRUE, 0};
+
+    for(size_t v = 0; v < num_vars; ++v){
+        m_var_to_level[v] = v;
+        m_level_to_var[v] = v;
+    }
+}
+
+//Function to get the BDD of a variable
+uint32_t bdd_manager::var(const size_t& v){
+    return make_node(v, BDD_FALSE, BDD_TRUE);
+}
+
+//Function to compute if f then g else h, which all the other operations are built on.
+//The results are memoized in a computed table, where every entry is overwritten by the next result that maps to it.
+//Returns BDD_FALSE if the manager has run out of nodes, which is signalled by overflowed()
+uint32_t bdd_manager::ite(const uint32_t& f, const uint32_t& g, const uint32_t& h){
+    if(m_overflow)
+        return BDD_FALSE;
+
+    if(f == BDD_TRUE || g == h)
+        return g;
+    if(f == BDD_FALSE)
+        return h;
+    if(g == BDD_TRUE && h == BDD_FALSE)
+        return f;
+
+    //Entry 0 of the table is initialized with f = 0, which never gets here, so it can't give false hits
+    const size_t cache_index = (f * 12582917ULL + g * 4256249ULL + h * 741457ULL) & (BDD_CACHE_SIZE - 1);
+    const cache_entry& entry = m_cache[cache_index];
+    if(entry.f == f && entry.g == g && entry.h == h)
+        return entry.result;
+
+    //Expand on the topmost variable of the three BDDs
+    const size_t top_level = min({level(f), level(g), level(h)});
+    const uint32_t top_var = m_level_to_var[top_level];
+    auto cofactor = [&](const uint32_t& n, const bool& value){
+        if(level(n) != top_level)
+            return n;
+        return value ? m_nodes[n].high : m_nodes[n].low;
+    };
+
+    const uint32_t low = ite(cofactor(f, false), cofactor(g, false), cofactor(h, false));
+    const uint32_t high = ite(cofactor(f, true), cofactor(g, true), cofactor(h, true));
+    const uint32_t result = make_node(top_var, low, high);
+
+    if(!m_overflow)
+        m_cache[cache_index] = cache_entry{f, g, h, result};
+
+    return result;
+}
+
+//Function to compute the exclusive or of two BDDs
+uint32_t bdd_manager::bdd_xor(const uint32_t& f, const uint32_t& g){
+    return ite(f, bdd_not(g), g);
+}
+
+//Function to evaluate a BDD for the specified values of the variables
+bool bdd_manager::eval(uint32_t f, const vector<bool>& values) const {
+    while(f > BDD_TRUE)
+        f = (values[m_nodes[f].var] ? m_nodes[f].high : m_nodes[f].low);
+
+    return f == BDD_TRUE;
+}
+
+//Function to count the assignments of all the variables for which a BDD is true.
+//It's computed as the fraction of the assignments for which it's true, times 2^(number of variables), so it's exact as
+//long as it fits in the mantissa of a double
+double bdd_manager::sat_count(const uint32_t& f) const {
+    unordered_map<uint32_t, double> fractions = {{BDD_FALSE, 0.0}, {BDD_TRUE, 1.0}};
+
+    function<double(const uint32_t&)> fraction = [&](const uint32_t& n){
+        const auto it = fractions.find(n);
+        if(it != fractions.end())
+            return it->second;
+
+        const double result = 0.5 * (fraction(m_nodes[n].low) + fraction(m_nodes[n].high));
+        fractions.emplace(n, result);
+        return result;
+    };
+
+    return ldexp(fraction(f), m_num_vars);
+}
+
+//Function to find an assignment of the variables for which a BDD is true. The variables the BDD doesn't depend on are
+//set to 0.
+//Returns false if there's no such assignment
+bool bdd_manager::pick_sat(uint32_t f, vector<bool>& values) const {
+    if(f == BDD_FALSE)
+        return false;
+
+    values.assign(m_num_vars, false);
+
+    //In a reduced BDD every node but BDD_FALSE has a path to BDD_TRUE
+    while(f > BDD_TRUE){
+        const bdd_node& node = m_nodes[f];
+        values[node.var] = (node.low == BDD_FALSE);
+        f = (node.low == BDD_FALSE ? node.high : node.low);
+    }
+
+    return true;
+}
+
+//Function to count the nodes, except for the terminal ones, shared by a set of BDDs
+size_t bdd_manager::size(const vector<uint32_t>& roots) const {
+    vector<uint8_t> visited(m_nodes.size(), false);
+    vector<uint32_t> to_visit(roots.begin(), roots.end());
+    size_t num_nodes = 0;
+
+    while(!to_visit.empty()){
+        const uint32_t n = to_visit.back();
+        to_visit.pop_back();
+
+        if(n <= BDD_TRUE || visited[n])
+            continue;
+
+        visited[n] = true;
+        ++num_nodes;
+        to_visit.push_back(m_nodes[n].low);
+        to_visit.push_back(m_nodes[n].high);
+    }
+
+    return num_nodes;
+}
+
+//Function to delete all the nodes that aren't referenced, directly or through other nodes
+void bdd_manager::collect_garbage(){
+    for(uint32_t n = BDD_TRUE + 1; n < m_nodes.size(); ++n){
+        if(m_nodes[n].var != NO_VAR && m_nodes[n].ref == 0)
+            delete_dead_node(n);
+    }
+
+    fill(m_cache.begin(), m_cache.end(), cache_entry{0, 0, 0, 0});
+}
+
+//Function to reorder the variables by sifting them one at a time, starting from the ones with the most nodes, to
+//reduce the number of nodes of the BDDs referenced. The unreferenced nodes are deleted
+void bdd_manager::reorder(){
+    collect_garbage();
+    m_reordering = true;
+
+    vector<size_t> vars(m_num_vars);
+    for(size_t v = 0; v < m_num_vars; ++v)
+        vars[v] = v;
+    sort(vars.begin(), vars.end(), [this](const size_t& a, const size_t& b){return m_unique[a].size() > m_unique[b].size();});
+
+    for(const auto& v : vars)
+        sift_var(v);
+
+    m_reordering = false;
+
+    //The nodes deleted while swapping can be reused, so the results in the computed table aren't valid anymore
+    fill(m_cache.begin(), m_cache.end(), cache_entry{0, 0, 0, 0});
+}
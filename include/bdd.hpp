@@ -0,0 +1,91 @@
+#ifndef BDD_HPP
+#define BDD_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+#define BDD_FALSE 0
+#define BDD_TRUE 1
+#define BDD_CACHE_SIZE (1 << 18)                    //Entries of the computed table, must be a power of 2
+#define BDD_MAX_NODES (1 << 25)                     //Default nodes after which the manager refuses to create new ones
+#define BDD_SIFTING_MAX_GROWTH 1.2                  //A variable stops being moved if the BDDs grow more than this
+#define BDD_FIRST_REORDER_NODES (1 << 16)           //Nodes at which a circuit's BDDs are first reordered while built
+
+//----------------------------------------------------------------------------------------------------------------------
+//Manager of reduced ordered binary decision diagrams, all sharing the same nodes and the same variables.
+//A BDD is identified by the index of its root node, and since the nodes are kept unique (by the unique table of each
+//variable), two BDDs of the same manager represent the same function if and only if they have the same root.
+//The nodes are reference counted: the BDDs kept by the user must be referenced with ref, and dereferenced with deref
+//when they aren't needed anymore. Unreferenced nodes are deleted only by collect_garbage and reorder, so the results of
+//the operations can be used freely until one of them is called.
+//The order of the variables can be changed with reorder (sifting), and the roots of the BDDs stay valid: the nodes are
+//modified in place, so each of them keeps representing the same function
+class bdd_manager{
+    private:
+        struct bdd_node{
+            uint32_t var;
+            uint32_t low;
+            uint32_t high;
+            uint32_t ref;
+        };
+
+        struct cache_entry{
+            uint32_t f;
+            uint32_t g;
+            uint32_t h;
+            uint32_t result;
+        };
+
+        size_t m_num_vars;
+        size_t m_max_nodes;
+        std::vector<bdd_node> m_nodes;
+        std::vector<uint32_t> m_free_nodes;
+        std::vector<std::unordered_map<uint64_t, uint32_t>> m_unique;   //For each variable, (low, high) -> node
+        std::vector<cache_entry> m_cache;
+        std::vector<size_t> m_var_to_level;
+        std::vector<size_t> m_level_to_var;
+        size_t m_num_live_nodes;
+        bool m_overflow;
+        bool m_reordering;
+
+        static uint64_t unique_key(const uint32_t& low, const uint32_t& high) {return (uint64_t(low) << 32) | high;}
+        size_t level(const uint32_t& f) const {return f <= BDD_TRUE ? m_num_vars : m_var_to_level[m_nodes[f].var];}
+
+        uint32_t make_node(const uint32_t& var, const uint32_t& low, const uint32_t& high);
+        void delete_dead_node(const uint32_t& f);
+        void swap_levels(const size_t& l);
+        void sift_var(const size_t& var);
+
+    public:
+        bdd_manager(const size_t& num_vars, const size_t& max_nodes = BDD_MAX_NODES);
+
+        bdd_manager(const bdd_manager&) = delete;
+        bdd_manager& operator=(const bdd_manager&) = delete;
+
+        size_t num_vars() const {return m_num_vars;}
+        size_t num_nodes() const {return m_num_live_nodes;}
+        bool overflowed() const {return m_overflow;}
+        size_t var_at_level(const size_t& l) const {return m_level_to_var[l];}
+
+        uint32_t var(const size_t& v);
+        void ref(const uint32_t& f) {++m_nodes[f].ref;}
+        void deref(const uint32_t& f) {--m_nodes[f].ref;}
+
+        uint32_t ite(const uint32_t& f, const uint32_t& g, const uint32_t& h);
+        uint32_t bdd_not(const uint32_t& f) {return ite(f, BDD_FALSE, BDD_TRUE);}
+        uint32_t bdd_and(const uint32_t& f, const uint32_t& g) {return ite(f, g, BDD_FALSE);}
+        uint32_t bdd_or(const uint32_t& f, const uint32_t& g) {return ite(f, BDD_TRUE, g);}
+        uint32_t bdd_xor(const uint32_t& f, const uint32_t& g);
+
+        bool eval(uint32_t f, const std::vector<bool>& values) const;
+        double sat_count(const uint32_t& f) const;
+        bool pick_sat(uint32_t f, std::vector<bool>& values) const;
+        size_t size(const std::vector<uint32_t>& roots) const;
+
+        void collect_garbage();
+        void reorder();
+};
+
+#endif
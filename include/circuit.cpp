@@ -1,17 +1,342 @@
 #include "circuit.hpp"
 #include "gates.hpp"
+#include "kernels.hpp"
+#include "mapped_file.hpp"
+#include "sat.hpp"
+#include "circuit_file.hpp"
 
 #include <map>
+#include <unordered_map>
 #include <utility>
 #include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <regex>
-#include <sstream>
+#include <string_view>
+#include <thread>
+#include <barrier>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <cctype>
+#include <cstddef>
+#include <numeric>
 
 using namespace std;
 
+//Function to transpose a 64x64 matrix of bits, with row i stored in a[i] and column j in bit j of every word
+static void transpose_64x64(uint64_t* a){
+    uint64_t mask = 0x00000000FFFFFFFF;
+    for(size_t j = 32; j != 0; j >>= 1, mask ^= (mask << j)){
+        for(size_t k = 0; k < 64; k = ((k | j) + 1) & ~j){
+            const uint64_t t = ((a[k] >> j) ^ a[k | j]) & mask;
+            a[k] ^= (t << j);
+            a[k | j] ^= t;
+        }
+    }
+}
+
+//Function to set the masks of the lanes holding vectors, among 64 * words_per_net lanes starting from first_vector, when
+//only num_vectors vectors exist: all of them but in the last pass over the vectors
+static void set_valid_lanes(const uint64_t& first_vector, const uint64_t& num_vectors, const size_t& words_per_net, uint64_t* valid_lanes){
+    for(size_t w = 0; w < words_per_net; ++w){
+        const uint64_t first_vector_word = first_vector + 64 * w;
+        if(first_vector_word + 64 <= num_vectors)
+            valid_lanes[w] = ~uint64_t(0);
+        else if(first_vector_word >= num_vectors)
+            valid_lanes[w] = 0;
+        else
+            valid_lanes[w] = (uint64_t(1) << (num_vectors - first_vector_word)) - 1;
+    }
+}
+
+//Turns of the workers handing over the blocks of a result to a writer, so that the blocks are written in order even if
+//they're computed out of order. The workers take the blocks in increasing order, so the next block to write is always
+//being computed by one of them, and none waits forever
+class block_turns{
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_turn_changed;
+        uint64_t m_next_block;
+
+    public:
+        block_turns() : m_next_block(0) {}
+
+        //Function to wait for the turn of a block, call the specified function and pass the turn to the next block
+        template<typename function_t>
+        void in_turn(const uint64_t& block, function_t fn){
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_turn_changed.wait(lock, [&](){return m_next_block == block;});
+            fn();
+            ++m_next_block;
+            m_turn_changed.notify_all();
+        }
+};
+
+//Pseudo-random generator of the xorshift family (xoshiro256**), used to draw random input vectors 64 at a time, one per
+//bit of every word: unlike the plain xorshift generators, all the bits of its words are equally random.
+//The state is initialized from the seed with splitmix64, as recommended by its authors
+class random_words{
+    private:
+        uint64_t m_state[4];
+
+        static uint64_t rotl(const uint64_t& x, const int& k) {return (x << k) | (x >> (64 - k));}
+
+    public:
+        random_words(uint64_t seed){
+            for(auto& s : m_state){
+                seed += 0x9E3779B97F4A7C15;
+                uint64_t z = seed;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+                s = z ^ (z >> 31);
+            }
+        }
+
+        uint64_t next(){
+            const uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+            const uint64_t t = m_state[1] << 17;
+
+            m_state[2] ^= m_state[0];
+            m_state[3] ^= m_state[1];
+            m_state[1] ^= m_state[2];
+            m_state[0] ^= m_state[3];
+            m_state[2] ^= t;
+            m_state[3] = rotl(m_state[3], 45);
+
+            return result;
+        }
+};
+
+//Function to compute the BDD of the output of an op, from the BDDs of the nets at its inputs
+static uint32_t apply_bdd_op(bdd_manager& manager, const gate_op& op, const uint32_t& in0, const uint32_t& in1){
+    const uint32_t a = (op.inv_in0 ? manager.bdd_not(in0) : in0);
+    const uint32_t b = (op.inv_in1 ? manager.bdd_not(in1) : in1);
+
+    switch(op.type){
+        case gate_type::buffer:
+            return a;
+        case gate_type::not_gate:
+            return manager.bdd_not(a);
+        case gate_type::and_gate:
+            return manager.bdd_and(a, b);
+        case gate_type::nand_gate:
+            return manager.bdd_not(manager.bdd_and(a, b));
+        case gate_type::or_gate:
+            return manager.bdd_or(a, b);
+        case gate_type::nor_gate:
+            return manager.bdd_not(manager.bdd_or(a, b));
+        case gate_type::xor_gate:
+            return manager.bdd_xor(a, b);
+        default:
+            return manager.bdd_not(manager.bdd_xor(a, b));
+    }
+}
+
+//Function to compute the checksum of the binary format of the circuits, over a buffer of whole uint64_t words
+static uint64_t binary_circuit_checksum(const char* data, const size_t& size){
+    uint64_t checksum = 0;
+    for(size_t i = 0; i < size; i += sizeof(uint64_t)){
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        checksum = (rotl(checksum, 5) ^ word) * 0x9E3779B97F4A7C15;
+    }
+
+    return checksum;
+}
+
+//Scanner of the text format of the circuits (see save_circuit_to_file), reading the file in place. The tokens of a line
+//are separated by spaces or tabs, and the lines can end with "\r\n". Every read function skips the blanks before its
+//token and remembers where the token starts, to point at it in the error messages
+class netlist_scanner{
+    private:
+        const char* m_text;
+        const char* m_text_end;
+        const char* m_line_start;
+        const char* m_token;
+        size_t m_line;
+
+        void skip_blanks(){
+            while(m_text < m_text_end && (*m_text == ' ' || *m_text == '\t'))
+                ++m_text;
+            m_token = m_text;
+        }
+
+    public:
+        netlist_scanner(const char* text, const char* text_end) :
+            m_text(text),
+            m_text_end(text_end),
+            m_line_start(text),
+            m_token(text),
+            m_line(1)
+        {}
+
+        bool at_end() const {return m_text == m_text_end;}
+        size_t line() const {return m_line;}
+        size_t column() const {return m_token - m_line_start + 1;}
+
+        //Function to read the character starting a line, returning 0 if it's the end of the line
+        char line_type(){
+            skip_blanks();
+            return (m_text < m_text_end && *m_text != '\r' && *m_text != '\n' ? *m_text++ : 0);
+        }
+
+        //Function to read an unsigned decimal number, failing if it has no digits or doesn't fit in a size_t
+        bool number(size_t& n){
+            skip_blanks();
+            n = 0;
+            while(m_text < m_text_end && *m_text >= '0' && *m_text <= '9'){
+                const size_t digit = *m_text++ - '0';
+                if(n > (SIZE_MAX - digit) / 10)
+                    return false;
+                n = 10 * n + digit;
+            }
+
+            return m_text != m_token;
+        }
+
+        //Function to read a 0 or a 1
+        bool bit(bool& b){
+            size_t n;
+            if(!number(n) || n > 1){
+                m_text = m_token;
+                return false;
+            }
+
+            b = n;
+            return true;
+        }
+
+        //Function to read the name of a gate type, as written by gate_type_to_str but without the leading blanks
+        bool type(gate_type& t){
+            static const char* names[] = {"BUF", "NOT", "AND", "OR", "XOR", "NND", "NOR", "NXR"};
+
+            skip_blanks();
+            const char* word_end = m_text;
+            while(word_end < m_text_end && *word_end >= 'A' && *word_end <= 'Z')
+                ++word_end;
+
+            for(size_t i = 0; i < 8; ++i){
+                if(size_t(word_end - m_text) == strlen(names[i]) && memcmp(m_text, names[i], word_end - m_text) == 0){
+                    t = static_cast<gate_type>(i);
+                    m_text = word_end;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        //Function to read the end of the current line, moving to the next one
+        bool end_of_line(){
+            skip_blanks();
+            if(m_text < m_text_end && *m_text == '\r')
+                ++m_text;
+            if(m_text == m_text_end)
+                return true;
+            if(*m_text != '\n')
+                return false;
+
+            m_line_start = m_token = ++m_text;
+            ++m_line;
+            return true;
+        }
+};
+
+//Scanner of the netlists in the ISCAS .bench format, reading the file in place like netlist_scanner. The names of the
+//nets can have any character but the blanks and "#(),=", and everything after a "#" is a comment
+class bench_scanner{
+    private:
+        const char* m_text;
+        const char* m_text_end;
+        const char* m_line_start;
+        const char* m_token;
+        size_t m_line;
+
+        void skip_blanks(){
+            while(m_text < m_text_end && (*m_text == ' ' || *m_text == '\t'))
+                ++m_text;
+            m_token = m_text;
+        }
+
+        static bool is_name_char(const char& c){
+            return c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != '#' && c != '(' && c != ')' && c != ',' && c != '=';
+        }
+
+    public:
+        bench_scanner(const char* text, const char* text_end) :
+            m_text(text),
+            m_text_end(text_end),
+            m_line_start(text),
+            m_token(text),
+            m_line(1)
+        {}
+
+        bool at_end() const {return m_text == m_text_end;}
+        size_t line() const {return m_line;}
+        size_t column() const {return m_token - m_line_start + 1;}
+
+        //Function to read the name of a net, a keyword or a gate type
+        bool name(string_view& n){
+            skip_blanks();
+            while(m_text < m_text_end && is_name_char(*m_text))
+                ++m_text;
+
+            n = string_view(m_token, m_text - m_token);
+            return !n.empty();
+        }
+
+        //Function to read the specified punctuation character
+        bool symbol(const char& c){
+            skip_blanks();
+            if(m_text == m_text_end || *m_text != c)
+                return false;
+
+            ++m_text;
+            return true;
+        }
+
+        //Function to check if the next character is the specified one, without reading it
+        bool peek(const char& c){
+            skip_blanks();
+            return m_text < m_text_end && *m_text == c;
+        }
+
+        //Function to read the end of the current line, with its comment if any, moving to the next one
+        bool end_of_line(){
+            skip_blanks();
+            if(m_text < m_text_end && *m_text == '#'){
+                const char* newline = static_cast<const char*>(memchr(m_text, '\n', m_text_end - m_text));
+                m_text = (newline == nullptr ? m_text_end : newline);
+            }
+            if(m_text < m_text_end && *m_text == '\r')
+                ++m_text;
+            if(m_text == m_text_end)
+                return true;
+            if(*m_text != '\n')
+                return false;
+
+            m_line_start = m_token = ++m_text;
+            ++m_line;
+            return true;
+        }
+};
+
+//Function to compare a name read from a .bench file with a keyword in upper case, ignoring the case of the name
+static bool bench_keyword(const string_view& name, const string_view& keyword){
+    if(name.size() != keyword.size())
+        return false;
+
+    for(size_t i = 0; i < name.size(); ++i){
+        if(toupper(static_cast<unsigned char>(name[i])) != keyword[i])
+            return false;
+    }
+
+    return true;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------
 //Circuit constructor
 circuit::circuit(const size_t& num_inputs, const size_t& num_outputs){
@@ -19,20 +344,20 @@ circuit::circuit(const size_t& num_inputs, const size_t& num_outputs){
     m_outputs = vector<bool>(num_outputs, false);
 
     m_next_gate_uid = 0;
+    m_kernel = sim_kernel::automatic;
+    m_compiled_stale = true;
+    m_event_driven = false;
+    m_net_values_valid = false;
+    m_first_event_layer = 0;
+    m_last_event_layer = 0;
 
     m_layers.emplace(make_pair(0, layer()));
-    for(size_t i = 0; i < num_inputs + 2; ++i){
-        m_layers[0].m_gates.emplace(make_pair(m_next_gate_uid, gate(gate_type::buffer, m_next_gate_uid)));
-        m_gates_in_layers.emplace(make_pair(m_next_gate_uid, 0));
-        ++m_next_gate_uid;
-    }
-
     m_layers.emplace(make_pair(-1, layer()));
-    for(size_t i = 0; i < num_outputs; ++i){
-        m_layers[-1].m_gates.emplace(make_pair(m_next_gate_uid, gate(gate_type::buffer, m_next_gate_uid)));
-        m_gates_in_layers.emplace(make_pair(m_next_gate_uid, -1));
-        ++m_next_gate_uid;
-    }
+    m_gates.reserve(num_inputs + 2 + num_outputs);
+    for(size_t i = 0; i < num_inputs + 2; ++i)
+        create_gate(m_next_gate_uid++, gate_type::buffer, 0);
+    for(size_t i = 0; i < num_outputs; ++i)
+        create_gate(m_next_gate_uid++, gate_type::buffer, -1);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------
@@ -42,20 +367,16 @@ circuit::~circuit() {}
 //------------------------------------------------------------------------------------------------------------------------------------
 //Set inputs and outputs of the circuit
 void circuit::set_io(const size_t& num_inputs, const size_t& num_outputs){
+    const sim_kernel kernel_to_keep = m_kernel;
+    const bool event_driven_to_keep = m_event_driven;
     *this = circuit(num_inputs, num_outputs);
+    m_kernel = kernel_to_keep;
+    m_event_driven = event_driven_to_keep;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------
 //Private members
 
-//Function to set the status of all the gates in the circuit to a specified status
-void circuit::set_all_gates_to_status(const status& s){
-    for(auto& l : m_layers){
-        for(auto& g : l.second.m_gates)
-            g.second.gate_status = s;
-    }
-}
-
 //Function to convert the gate type to a string
 string circuit::gate_type_to_str(const gate_type& g){
     string ret;
@@ -97,41 +418,616 @@ string circuit::gate_type_to_str(const gate_type& g){
     return ret;
 }
 
+//Function to store a new gate, with its inputs not connected, in an existing layer. It takes the last index freed by
+//destroy_gate, if any, otherwise the next one, so the gates created by the constructor (the input layer first) are at
+//the indices equal to their uids. Returns the index of the gate
+uint32_t circuit::create_gate(const size_t& uid, const gate_type& type, const size_t& num_layer){
+    uint32_t index;
+    if(m_free_indices.empty()){
+        index = m_gates.size();
+        m_gates.emplace_back(type);
+        m_gate_uids.push_back(uid);
+        m_gate_layers.push_back(num_layer);
+        m_fanouts.emplace_back();
+    }
+    else {
+        index = m_free_indices.back();
+        m_free_indices.pop_back();
+        m_gates[index] = gate(type);
+        m_gate_uids[index] = uid;
+        m_gate_layers[index] = num_layer;
+    }
+
+    //The uids are mostly increasing, so the gate usually goes at the end of its layer
+    vector<uint32_t>& indices = m_layers[num_layer].m_indices;
+    auto it = indices.end();
+    if(!indices.empty() && m_gate_uids[indices.back()] > uid)
+        it = lower_bound(indices.begin(), indices.end(), uid, [this](const uint32_t& i, const size_t& u){return m_gate_uids[i] < u;});
+    indices.insert(it, index);
+
+    m_gate_indices.emplace(uid, index);
+    m_compiled_stale = true;
+
+    return index;
+}
+
+//Function to remove a gate from its layer, freeing its index, after disconnecting its inputs and the inputs of the gates
+//connected to its output
+void circuit::destroy_gate(const uint32_t& index){
+    disconnect_input(index, 0);
+    disconnect_input(index, 1);
+    for(const auto& pin : m_fanouts[index])
+        (pin & 1 ? m_gates[pin >> 1].in1 : m_gates[pin >> 1].in0) = NO_GATE;
+    m_fanouts[index].clear();
+
+    vector<uint32_t>& indices = m_layers[m_gate_layers[index]].m_indices;
+    const size_t uid = m_gate_uids[index];
+    indices.erase(lower_bound(indices.begin(), indices.end(), uid, [this](const uint32_t& i, const size_t& u){return m_gate_uids[i] < u;}));
+
+    m_gate_indices.erase(uid);
+    m_free_indices.push_back(index);
+    m_compiled_stale = true;
+}
+
+//Function to connect an input of a gate to the output of another one, replacing its previous connection, if any
+void circuit::connect_input(const uint32_t& index, const bool& num_input, const uint32_t& index_out, const bool& inv){
+    disconnect_input(index, num_input);
+
+    gate& g = m_gates[index];
+    (num_input ? g.in1 : g.in0) = index_out;
+    (num_input ? g.inv_in1 : g.inv_in0) = inv;
+    m_fanouts[index_out].push_back(2 * index + num_input);
+    m_compiled_stale = true;
+}
+
+//Function to disconnect an input of a gate, if it's connected, removing it from the fanout of the gate it reads. The
+//fanouts aren't ordered, so the last input of the fanout takes its place
+void circuit::disconnect_input(const uint32_t& index, const bool& num_input){
+    uint32_t& index_out = (num_input ? m_gates[index].in1 : m_gates[index].in0);
+    if(index_out == NO_GATE)
+        return;
+
+    vector<uint32_t>& fanout = m_fanouts[index_out];
+    *find(fanout.begin(), fanout.end(), 2 * index + num_input) = fanout.back();
+    fanout.pop_back();
+    index_out = NO_GATE;
+    m_compiled_stale = true;
+}
+
 //Function to add a gate specifying also its uid (use with caution)
 int circuit::add_gate_with_uid(const size_t& uid, const gate& g, const size_t& num_layer){
     if(num_layer != 0 && num_layer != static_cast<size_t>(-1) && m_layers.contains(num_layer)){
-        if(m_gates_in_layers.contains(uid))
+        if(m_gate_indices.contains(uid))
             return 2;
 
-        m_layers[num_layer].m_gates[uid] = gate(g.type, uid);
-        m_gates_in_layers[uid] = num_layer;
+        create_gate(uid, g.type, num_layer);
         return 0;
     } else
         return 1;
 }
 
-//Function to add a phantom connection, i.e. a connection that doesn't affect the gates (use with caution)
-int circuit::add_phantom_connection(const size_t& gate_out_uid, const bool& take_inv_output, const size_t& gate_in_uid, const bool& num_input){
-    //Check input validity
-    if(!m_gates_in_layers.contains(gate_out_uid) || !m_gates_in_layers.contains(gate_in_uid))
-        return -1;
+//Function to remove a set of gates, none of which can be in the input or output layer, together with the layers left
+//empty by their removal. No gate outside the set may be connected to a gate of the set, so that no input is left
+//reading a freed index; the fanouts have to be regenerated afterwards (see regen_fanouts)
+void circuit::remove_gates(const vector<size_t>& uids){
+    vector<uint8_t> removed(m_gates.size(), false);
+    for(const auto& uid : uids){
+        const uint32_t index = gate_index(uid);
+        removed[index] = true;
+        m_gate_indices.erase(uid);
+        m_free_indices.push_back(index);
+    }
 
-    if(!(m_gates_in_layers[gate_out_uid] < m_gates_in_layers[gate_in_uid]))
-        return 3;
+    //Every layer is compacted at once, instead of erasing the gates one by one
+    for(auto it_l = m_layers.begin(); it_l != m_layers.end();){
+        vector<uint32_t>& indices = it_l->second.m_indices;
+        const size_t size_before = indices.size();
+        erase_if(indices, [&](const uint32_t& i){return removed[i];});
+
+        if(indices.empty() && size_before > 0)
+            it_l = m_layers.erase(it_l);
+        else
+            ++it_l;
+    }
+
+    m_compiled_stale = true;
+}
+
+//Function to list the gates, outside the input and output layers, that don't reach any output of the circuit, going
+//through the layers in reverse order
+void circuit::find_unreachable_gates(vector<size_t>& uids) const {
+    vector<uint8_t> reaches_output(m_gates.size(), false);
+    for(const auto& i : m_layers.at(static_cast<size_t>(-1)).m_indices)
+        reaches_output[i] = true;
+
+    for(auto it_l = m_layers.rbegin(); it_l != m_layers.rend(); ++it_l){
+        for(const auto& i : it_l->second.m_indices){
+            if(!reaches_output[i])
+                continue;
+
+            if(m_gates[i].in0 != NO_GATE)
+                reaches_output[m_gates[i].in0] = true;
+            if(m_gates[i].in1 != NO_GATE)
+                reaches_output[m_gates[i].in1] = true;
+        }
+    }
+
+    uids.clear();
+    for(const auto& l : m_layers){
+        if(l.first == 0 || l.first == static_cast<size_t>(-1))
+            continue;
+
+        for(const auto& i : l.second.m_indices){
+            if(!reaches_output[i])
+                uids.push_back(m_gate_uids[i]);
+        }
+    }
+}
+
+//Function to flatten the layers of the circuit in a topologically ordered array of gate_ops.
+//Nets 0 and 1 are the constants, followed by the inputs of the circuit, then one net for each other gate.
+//Returns 1 if some gates in the circuit have their inputs not connected
+int circuit::build_flat_netlist(flat_netlist& fn){
+    fn.m_ops.clear();
+    fn.m_output_nets.clear();
+    fn.m_layer_offsets.clear();
+    fn.m_net_uids.clear();
+
+    vector<uint32_t> net_of_gate(m_gates.size());
+    uint32_t next_net = 0;
+
+    fn.m_ops.reserve(m_gate_indices.size());
+    fn.m_net_uids.reserve(m_gate_indices.size());
+    for(const auto& i : m_layers[0].m_indices){
+        net_of_gate[i] = next_net++;
+        fn.m_net_uids.push_back(m_gate_uids[i]);
+    }
+
+    for(const auto& l : m_layers){
+        if(l.first == 0)
+            continue;
+
+        fn.m_layer_offsets.push_back(fn.m_ops.size());
+        for(const auto& i : l.second.m_indices){
+            const gate& g = m_gates[i];
+            gate_op op;
+            op.type = g.type;
+            op.inv_in0 = g.inv_in0;
+            op.inv_in1 = g.inv_in1;
+
+            if(g.type == gate_type::buffer || g.type == gate_type::not_gate){
+                if(g.in0 == NO_GATE && g.in1 == NO_GATE)
+                    return 1;
+
+                //With both inputs connected, buffers and NOT gates behave as OR and NOR gates
+                if(g.in0 != NO_GATE && g.in1 != NO_GATE){
+                    op.type = (g.type == gate_type::buffer ? gate_type::or_gate : gate_type::nor_gate);
+                    op.net_in0 = net_of_gate[g.in0];
+                    op.net_in1 = net_of_gate[g.in1];
+                }
+                else if(g.in0 != NO_GATE){
+                    op.net_in0 = op.net_in1 = net_of_gate[g.in0];
+                    op.inv_in1 = op.inv_in0;
+                }
+                else {
+                    op.net_in0 = op.net_in1 = net_of_gate[g.in1];
+                    op.inv_in0 = op.inv_in1;
+                }
+            }
+            else {
+                if(g.in0 == NO_GATE || g.in1 == NO_GATE)
+                    return 1;
+
+                op.net_in0 = net_of_gate[g.in0];
+                op.net_in1 = net_of_gate[g.in1];
+            }
+
+            op.net_out = next_net;
+            net_of_gate[i] = next_net++;
+            fn.m_ops.push_back(op);
+            fn.m_net_uids.push_back(m_gate_uids[i]);
+
+            if(l.first == static_cast<size_t>(-1))
+                fn.m_output_nets.push_back(op.net_out);
+        }
+    }
 
-    //Update the vector containing info on the connections in the circuit
-    auto it_phantom_connections = find_if(m_phantom_connections.begin(), m_phantom_connections.end(),
-                                          [&](const connection& c) -> bool{
-                                          return c.m_uid_input == gate_in_uid && c.m_num_input == num_input;
-                                          });
+    fn.m_num_nets = next_net;
+    fn.m_layer_offsets.push_back(fn.m_ops.size());
 
-    if(it_phantom_connections != m_phantom_connections.end())
-        m_phantom_connections.erase(it_phantom_connections);
-    m_phantom_connections.emplace_back(gate_out_uid, take_inv_output, gate_in_uid, num_input);
+    fn.m_op_layers.resize(fn.m_ops.size());
+    for(size_t l = 0; l + 1 < fn.m_layer_offsets.size(); ++l)
+        fill(fn.m_op_layers.begin() + fn.m_layer_offsets[l], fn.m_op_layers.begin() + fn.m_layer_offsets[l + 1], l);
+
+    //Build the fanout lists of all the nets (an op reading the same net from both inputs is listed only once)
+    fn.m_fanout_offsets.assign(fn.m_num_nets + 1, 0);
+    for(const auto& op : fn.m_ops){
+        ++fn.m_fanout_offsets[op.net_in0 + 1];
+        if(op.net_in1 != op.net_in0)
+            ++fn.m_fanout_offsets[op.net_in1 + 1];
+    }
+    for(size_t i = 0; i < fn.m_num_nets; ++i)
+        fn.m_fanout_offsets[i + 1] += fn.m_fanout_offsets[i];
+
+    vector<uint32_t> next_fanout(fn.m_fanout_offsets.begin(), fn.m_fanout_offsets.end() - 1);
+    fn.m_fanout_ops.resize(fn.m_fanout_offsets.back());
+    for(uint32_t i = 0; i < fn.m_ops.size(); ++i){
+        fn.m_fanout_ops[next_fanout[fn.m_ops[i].net_in0]++] = i;
+        if(fn.m_ops[i].net_in1 != fn.m_ops[i].net_in0)
+            fn.m_fanout_ops[next_fanout[fn.m_ops[i].net_in1]++] = i;
+    }
 
     return 0;
 }
 
+//Function to run all the ops of the compiled circuit over a buffer of nets.
+//With more than one thread, the gates of the layers with at least LAYER_PARALLEL_MIN_GATES gates are split between the
+//workers of the pool of the circuit (up to num_threads, see pool_workers), which wait for each other at the end of the
+//layer. Consecutive smaller layers are grouped and run by a single worker, since splitting them wouldn't amortize the
+//synchronization. If there are no big layers, the pool isn't used
+void circuit::run_ops(uint64_t* nets, const size_t& words_per_net, const size_t& num_threads) const {
+    const flat_netlist& fn = m_compiled;
+    const kernel_fn kernel = get_kernel(m_kernel);
+
+    //Ranges of ops run one after the other, either split between the threads or not
+    struct segment{
+        uint32_t m_first_op;
+        uint32_t m_last_op;
+        bool m_parallel;
+    };
+
+    vector<segment> segments;
+    if(num_threads > 1){
+        for(size_t l = 0; l + 1 < fn.m_layer_offsets.size(); ++l){
+            const uint32_t first_op = fn.m_layer_offsets[l];
+            const uint32_t last_op = fn.m_layer_offsets[l + 1];
+            const bool parallel = (last_op - first_op >= LAYER_PARALLEL_MIN_GATES);
+
+            if(!parallel && !segments.empty() && !segments.back().m_parallel)
+                segments.back().m_last_op = last_op;
+            else
+                segments.push_back({first_op, last_op, parallel});
+        }
+    }
+
+    uint32_t widest_segment = 0;
+    for(const auto& s : segments){
+        if(s.m_parallel)
+            widest_segment = max(widest_segment, s.m_last_op - s.m_first_op);
+    }
+
+    const size_t num_workers = pool_workers(num_threads, widest_segment);
+    if(num_workers == 1){
+        kernel(fn.m_ops.data(), fn.m_ops.size(), nets, words_per_net);
+        return;
+    }
+
+    barrier end_of_segment(num_workers);
+    m_pool.run(num_workers, [&](const size_t& t){
+        for(const auto& s : segments){
+            if(s.m_parallel){
+                const uint32_t num_ops = s.m_last_op - s.m_first_op;
+                const uint32_t first_op = s.m_first_op + num_ops * t / num_workers;
+                const uint32_t last_op = s.m_first_op + num_ops * (t + 1) / num_workers;
+                kernel(fn.m_ops.data() + first_op, last_op - first_op, nets, words_per_net);
+            }
+            else if(t == 0)
+                kernel(fn.m_ops.data() + s.m_first_op, s.m_last_op - s.m_first_op, nets, words_per_net);
+
+            end_of_segment.arrive_and_wait();
+        }
+    });
+}
+
+//Function to run the bit-parallel engine once over a buffer of nets, whose constants and inputs must be already set, and
+//gather the outputs. The circuit must be compiled. This doesn't change the state of the circuit, so multiple threads
+//can call it at once, each with its own buffer of nets
+void circuit::run_wide_pass(uint64_t* nets, uint64_t* outputs, const size_t& words_per_net, const size_t& num_threads) const {
+    const flat_netlist& fn = m_compiled;
+
+    if(m_native){
+        m_native->eval(nets + 2 * words_per_net, outputs, words_per_net);
+        return;
+    }
+
+    run_ops(nets, words_per_net, num_threads);
+
+    for(size_t i = 0; i < fn.m_output_nets.size(); ++i)
+        copy_n(nets + fn.m_output_nets[i] * words_per_net, words_per_net, outputs + i * words_per_net);
+}
+
+//Function to simulate num_rows rows of the truth table, starting from first_row, and append them as text to the
+//specified string. The circuit must be compiled. Like run_wide_pass, it can be called by multiple threads at once
+void circuit::format_truth_table_rows(const uint64_t& first_row, const uint64_t& num_rows, string& text) const {
+    //Patterns taken by the first 6 inputs in a word that contains 64 consecutive rows of the truth table
+    static const uint64_t low_inputs_patterns[6] = {0xAAAAAAAAAAAAAAAA, 0xCCCCCCCCCCCCCCCC, 0xF0F0F0F0F0F0F0F0,
+                                                    0xFF00FF00FF00FF00, 0xFFFF0000FFFF0000, 0xFFFFFFFF00000000};
+    const size_t words_per_net = TRUTH_TABLE_WORDS_PER_NET;
+    const size_t rows_per_pass = 64 * words_per_net;
+    const size_t num_inputs = m_inputs.size();
+    const size_t num_outputs = m_outputs.size();
+    const uint64_t last_row = min(first_row + num_rows, uint64_t(1) << num_inputs);
+
+    vector<uint64_t> nets(m_compiled.m_num_nets * words_per_net, 0);
+    vector<uint64_t> outputs(num_outputs * words_per_net);
+    fill(nets.begin() + words_per_net, nets.begin() + 2 * words_per_net, ~uint64_t(0));
+
+    string row(num_inputs + 3 + num_outputs + 1, ' ');
+    row[num_inputs + 1] = '|';
+    row.back() = '\n';
+
+    for(uint64_t pass_row = first_row; pass_row < last_row; pass_row += rows_per_pass){
+        for(size_t i = 0; i < num_inputs; ++i){
+            for(size_t w = 0; w < words_per_net; ++w){
+                if(i < 6)
+                    nets[(i + 2) * words_per_net + w] = low_inputs_patterns[i];
+                else
+                    nets[(i + 2) * words_per_net + w] = (((pass_row + 64 * w) >> i) & 1 ? ~uint64_t(0) : 0);
+            }
+        }
+
+        run_wide_pass(nets.data(), outputs.data(), words_per_net);
+
+        for(uint64_t r = pass_row; r < min(pass_row + rows_per_pass, last_row); ++r){
+            const size_t word = (r - pass_row) / 64;
+            const size_t bit = (r - pass_row) % 64;
+
+            for(size_t i = 0; i < num_inputs; ++i)
+                row[i] = '0' + ((r >> i) & 1);
+            for(size_t j = 0; j < num_outputs; ++j)
+                row[num_inputs + 3 + j] = '0' + ((outputs[j * words_per_net + word] >> bit) & 1);
+
+            text += row;
+        }
+    }
+}
+
+//Function to simulate the rows of the truth table in [first_row, first_row + num_rows), packing the values of each output
+//in a column of (num_rows + 63) / 64 words, stored one after the other in columns (see packed_truth_table_header).
+//first_row must be a multiple of 64. The circuit must be compiled. Like run_wide_pass, it can be called by multiple
+//threads at once
+void circuit::pack_truth_table_rows(const uint64_t& first_row, const uint64_t& num_rows, uint64_t* columns) const {
+    //Patterns taken by the first 6 inputs in a word that contains 64 consecutive rows of the truth table
+    static const uint64_t low_inputs_patterns[6] = {0xAAAAAAAAAAAAAAAA, 0xCCCCCCCCCCCCCCCC, 0xF0F0F0F0F0F0F0F0,
+                                                    0xFF00FF00FF00FF00, 0xFFFF0000FFFF0000, 0xFFFFFFFF00000000};
+    const size_t words_per_net = TRUTH_TABLE_WORDS_PER_NET;
+    const size_t rows_per_pass = 64 * words_per_net;
+    const size_t num_inputs = m_inputs.size();
+    const size_t num_outputs = m_outputs.size();
+    const size_t words_per_column = (num_rows + 63) / 64;
+    //Mask of the rows actually simulated in the last word of the columns, when they're less than 64
+    const uint64_t last_word_mask = (num_rows % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (num_rows % 64)) - 1);
+
+    vector<uint64_t> nets(m_compiled.m_num_nets * words_per_net, 0);
+    vector<uint64_t> outputs(num_outputs * words_per_net);
+    fill(nets.begin() + words_per_net, nets.begin() + 2 * words_per_net, ~uint64_t(0));
+
+    for(uint64_t pass_row = first_row; pass_row < first_row + num_rows; pass_row += rows_per_pass){
+        for(size_t i = 0; i < num_inputs; ++i){
+            for(size_t w = 0; w < words_per_net; ++w){
+                if(i < 6)
+                    nets[(i + 2) * words_per_net + w] = low_inputs_patterns[i];
+                else
+                    nets[(i + 2) * words_per_net + w] = (((pass_row + 64 * w) >> i) & 1 ? ~uint64_t(0) : 0);
+            }
+        }
+
+        run_wide_pass(nets.data(), outputs.data(), words_per_net);
+
+        const size_t first_word = (pass_row - first_row) / 64;
+        const size_t num_words = min(words_per_net, words_per_column - first_word);
+        for(size_t j = 0; j < num_outputs; ++j)
+            copy_n(outputs.begin() + j * words_per_net, num_words, columns + j * words_per_column + first_word);
+    }
+
+    for(size_t j = 0; j < num_outputs; ++j)
+        columns[(j + 1) * words_per_column - 1] &= last_word_mask;
+}
+
+//Function to load 64 * words_per_net input vectors, packed like in simulate_batch starting from first_vector, in the
+//nets of the inputs. The vectors are transposed 64 vectors by 64 inputs at a time, so that every word holds the same
+//input of 64 vectors. Past the last vector, the words are filled with zeros
+void circuit::pack_vectors_in_nets(span<const uint64_t> inputs, const size_t& num_vectors, const size_t& first_vector, uint64_t* nets, const size_t& words_per_net) const {
+    const size_t num_inputs = m_inputs.size();
+    const size_t in_words = input_words_per_vector();
+
+    uint64_t block[64];
+    for(size_t w = 0; w < words_per_net; ++w){
+        const size_t first_vector_word = first_vector + 64 * w;
+
+        for(size_t b = 0; b < in_words; ++b){
+            for(size_t v = 0; v < 64; ++v)
+                block[v] = (first_vector_word + v < num_vectors ? inputs[(first_vector_word + v) * in_words + b] : 0);
+
+            transpose_64x64(block);
+            for(size_t i = b * 64; i < min(num_inputs, (b + 1) * 64); ++i)
+                nets[(i + 2) * words_per_net + w] = block[i - b * 64];
+        }
+    }
+}
+
+//Function to schedule the evaluation of all the ops reading a net, for the event-driven simulation
+void circuit::schedule_fanout(const uint32_t& net){
+    const flat_netlist& fn = m_compiled;
+
+    for(uint32_t i = fn.m_fanout_offsets[net]; i < fn.m_fanout_offsets[net + 1]; ++i){
+        const uint32_t op_index = fn.m_fanout_ops[i];
+        if(!m_op_scheduled[op_index]){
+            const uint32_t layer_index = fn.m_op_layers[op_index];
+            m_op_scheduled[op_index] = true;
+            m_events[layer_index].push_back(op_index);
+            m_first_event_layer = min<size_t>(m_first_event_layer, layer_index);
+            m_last_event_layer = max<size_t>(m_last_event_layer, layer_index);
+        }
+    }
+}
+
+//Function to propagate the changes of the inputs through the circuit, event-driven.
+//Only the ops reading a net whose value changed are evaluated, and if the output of an op doesn't change its fanout
+//isn't evaluated either. Since ops only read nets from previous layers, evaluating the scheduled ones layer by layer
+//guarantees that every op is evaluated at most once
+void circuit::simulate_events(){
+    for(size_t i = 0; i < m_inputs.size(); ++i){
+        const uint64_t new_value = (m_inputs[i] ? ~uint64_t(0) : 0);
+        if(m_net_values[i + 2] != new_value){
+            m_net_values[i + 2] = new_value;
+            schedule_fanout(i + 2);
+        }
+    }
+
+    propagate_events();
+}
+
+//Function to evaluate the scheduled ops, and schedule the fanout of those whose output changed, until no event is left
+void circuit::propagate_events(){
+    const flat_netlist& fn = m_compiled;
+    const uint32_t first_op_net = m_inputs.size() + 2;
+
+    //Evaluating an op only schedules ops of later layers, so m_last_event_layer can grow while looping
+    for(size_t l = m_first_event_layer; l <= m_last_event_layer && l < m_events.size(); ++l){
+        for(const auto& op_index : m_events[l]){
+            m_op_scheduled[op_index] = false;
+
+            const gate_op& op = fn.m_ops[op_index];
+            const uint64_t new_value = op.eval(m_net_values[op.net_in0], m_net_values[op.net_in1]);
+            if(m_net_values[op.net_out] != new_value){
+                m_net_values[op.net_out] = new_value;
+                schedule_fanout(first_op_net + op_index);
+            }
+        }
+
+        m_events[l].clear();
+    }
+
+    m_first_event_layer = m_events.size();
+    m_last_event_layer = 0;
+}
+
+//Function to list the stuck-at-0 and stuck-at-1 faults of all the gates: on their outputs, except for the constants, and
+//on their connected inputs. For each of them, the way to inject it in the compiled circuit is listed in targets.
+//The circuit must be compiled
+void circuit::enumerate_faults(vector<fault>& faults, vector<fault_target>& targets){
+    const flat_netlist& fn = m_compiled;
+
+    vector<uint32_t> net_of_gate(m_gates.size());
+    for(uint32_t net = 0; net < fn.m_num_nets; ++net)
+        net_of_gate[gate_index(fn.m_net_uids[net])] = net;
+
+    faults.clear();
+    targets.clear();
+    for(const auto& l : m_layers){
+        for(const auto& i : l.second.m_indices){
+            const gate& g = m_gates[i];
+            const size_t uid = m_gate_uids[i];
+            const uint32_t net = net_of_gate[i];
+            if(l.first == 0 && net < 2)
+                continue;
+
+            //Buffers and NOT gates with a single input connected read it from both the inputs of their op
+            const bool single_input = (g.in0 == NO_GATE || g.in1 == NO_GATE);
+
+            for(const bool stuck_at : {false, true}){
+                faults.emplace_back(uid, fault_site::output, stuck_at);
+                targets.push_back(fault_target{net, 0, stuck_at});
+            }
+
+            if(l.first == 0)
+                continue;
+
+            for(const bool stuck_at : {false, true}){
+                if(g.in0 != NO_GATE){
+                    faults.emplace_back(uid, fault_site::input0, stuck_at);
+                    targets.push_back(fault_target{net, uint8_t(single_input ? 3 : 1), stuck_at});
+                }
+                if(g.in1 != NO_GATE){
+                    faults.emplace_back(uid, fault_site::input1, stuck_at);
+                    targets.push_back(fault_target{net, uint8_t(single_input ? 3 : 2), stuck_at});
+                }
+            }
+        }
+    }
+}
+
+//Function to inject a fault in the faulty nets of the workspace, which must be equal to the good ones, and propagate its
+//effects event-driven, like propagate_events, only through the gates whose inputs are affected by it.
+//Returns the index of the first lane, among the valid ones, in which an output differs from the good circuit, or
+//FAULT_NOT_DETECTED. The faulty nets are restored to the good values before returning
+size_t circuit::propagate_fault(const fault_target& target, const uint64_t* good_nets, const uint64_t* valid_lanes, const vector<uint8_t>& is_output_net, fault_workspace& ws) const {
+    const flat_netlist& fn = m_compiled;
+    const size_t words_per_net = FAULT_SIM_WORDS_PER_NET;
+    const uint32_t first_op_net = m_inputs.size() + 2;
+    const kernel_fn kernel = get_kernel(m_kernel);
+    uint64_t* faulty_nets = ws.m_faulty_nets.data();
+    size_t first_event_layer = ws.m_events.size();
+    size_t last_event_layer = 0;
+
+    //Function to evaluate an op on the faulty nets, scheduling its fanout if its output is affected by the fault
+    auto eval_op = [&](const gate_op& op){
+        kernel(&op, 1, faulty_nets, words_per_net);
+        ws.m_touched_nets.push_back(op.net_out);
+
+        uint64_t changed = 0;
+        for(size_t w = 0; w < words_per_net; ++w)
+            changed |= faulty_nets[op.net_out * words_per_net + w] ^ good_nets[op.net_out * words_per_net + w];
+
+        if(changed == 0)
+            return;
+
+        for(uint32_t i = fn.m_fanout_offsets[op.net_out]; i < fn.m_fanout_offsets[op.net_out + 1]; ++i){
+            const uint32_t op_index = fn.m_fanout_ops[i];
+            if(!ws.m_op_scheduled[op_index]){
+                const uint32_t layer_index = fn.m_op_layers[op_index];
+                ws.m_op_scheduled[op_index] = true;
+                ws.m_events[layer_index].push_back(op_index);
+                first_event_layer = min<size_t>(first_event_layer, layer_index);
+                last_event_layer = max<size_t>(last_event_layer, layer_index);
+            }
+        }
+    };
+
+    //Inject the fault, either forcing the net or forcing the inputs of the op driving it
+    gate_op faulty_op{gate_type::buffer, false, false, target.m_stuck_at, target.m_stuck_at, target.m_net};
+    if(target.m_forced_inputs != 0){
+        faulty_op = fn.m_ops[target.m_net - first_op_net];
+        if(target.m_forced_inputs & 1){
+            faulty_op.net_in0 = target.m_stuck_at;
+            faulty_op.inv_in0 = false;
+        }
+        if(target.m_forced_inputs & 2){
+            faulty_op.net_in1 = target.m_stuck_at;
+            faulty_op.inv_in1 = false;
+        }
+    }
+    eval_op(faulty_op);
+
+    //Evaluating an op only schedules ops of later layers, so last_event_layer can grow while looping
+    for(size_t l = first_event_layer; l <= last_event_layer && l < ws.m_events.size(); ++l){
+        for(const auto& op_index : ws.m_events[l]){
+            ws.m_op_scheduled[op_index] = false;
+            eval_op(fn.m_ops[op_index]);
+        }
+
+        ws.m_events[l].clear();
+    }
+
+    //Compare the outputs reached by the fault, and restore all the nets touched
+    size_t detecting_lane = FAULT_NOT_DETECTED;
+    for(const auto& net : ws.m_touched_nets){
+        if(is_output_net[net]){
+            for(size_t w = 0; w < words_per_net; ++w){
+                const uint64_t diff = (faulty_nets[net * words_per_net + w] ^ good_nets[net * words_per_net + w]) & valid_lanes[w];
+                if(diff != 0)
+                    detecting_lane = min(detecting_lane, w * 64 + countr_zero(diff));
+            }
+        }
+
+        copy_n(good_nets + net * words_per_net, words_per_net, faulty_nets + net * words_per_net);
+    }
+    ws.m_touched_nets.clear();
+
+    return detecting_lane;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------
 //Methods to add elements to the circuit
 
@@ -148,9 +1044,7 @@ int circuit::add_layer(const size_t& num_layer){
 //Add gate in an existing layer of the circuit. It must not be the input nor the output layer
 int circuit::add_gate(const gate& g, const size_t& num_layer){
     if(num_layer != 0 && num_layer != static_cast<size_t>(-1) && m_layers.contains(num_layer)){
-        m_layers[num_layer].m_gates.emplace(make_pair(m_next_gate_uid, gate(g.type, m_next_gate_uid)));
-        m_gates_in_layers.emplace(make_pair(m_next_gate_uid, num_layer));
-        ++m_next_gate_uid;
+        create_gate(m_next_gate_uid++, g.type, num_layer);
         return 0;
     } else
         return 1;
@@ -163,10 +1057,10 @@ int circuit::add_connection(const size_t& gate_out_uid, const size_t& gate_in_ui
 
 //Add a connection to two gates by just specifying the uids of the two gates, whether to take the inverted input of the giving gate, and the input number (0 or 1) of the receiving gate
 int circuit::add_connection(const size_t& gate_out_uid, const bool& take_inv_output, const size_t& gate_in_uid, const bool& num_input){
-    if(!m_gates_in_layers.contains(gate_out_uid) || !m_gates_in_layers.contains(gate_in_uid))
+    if(!m_gate_indices.contains(gate_out_uid) || !m_gate_indices.contains(gate_in_uid))
         return -1;
     else
-        return add_connection(m_gates_in_layers[gate_out_uid], gate_out_uid, take_inv_output, m_gates_in_layers[gate_in_uid], gate_in_uid, num_input);
+        return add_connection(layer_of(gate_out_uid), gate_out_uid, take_inv_output, layer_of(gate_in_uid), gate_in_uid, num_input);
 }
 
 //Add a connection to two gates by specifying the uids of the gates, that layer in which they're in, and the input number (0 or 1) of the receiving gate
@@ -177,37 +1071,20 @@ int circuit::add_connection(const size_t& num_layer_output, const size_t& gate_o
 //Add a connection to two gates by specifying the uids of the gates, the layer in which they're in, whether to take the inverted input of the giving gate, and the input number (0 or 1) of the receiving gate
 int circuit::add_connection(const size_t& num_layer_output, const size_t& gate_out_uid, const bool& take_inv_output, const size_t& num_layer_input, const size_t& gate_in_uid, const bool& num_input){
     //Check input validity
-    if(!m_gates_in_layers.contains(gate_out_uid) || !m_gates_in_layers.contains(gate_in_uid))
+    if(!m_gate_indices.contains(gate_out_uid) || !m_gate_indices.contains(gate_in_uid))
         return -1;
 
     if(!m_layers.contains(num_layer_output) || !m_layers.contains(num_layer_input))
         return 1;
 
-    if(!m_layers[num_layer_output].m_gates.contains(gate_out_uid) || !m_layers[num_layer_input].m_gates.contains(gate_in_uid))
+    if(layer_of(gate_out_uid) != num_layer_output || layer_of(gate_in_uid) != num_layer_input)
         return 2;
 
     if(!(num_layer_output < num_layer_input))
         return 3;
 
     //Connect the gates to one another
-    gate* ptr_gate = &(m_layers[num_layer_output].m_gates[gate_out_uid]);
-    if(num_input == 0){
-        m_layers[num_layer_input].m_gates[gate_in_uid].ptr_gate_in0 = ptr_gate;
-        m_layers[num_layer_input].m_gates[gate_in_uid].take_inv_output_in_in0 = take_inv_output;
-    } else {
-        m_layers[num_layer_input].m_gates[gate_in_uid].ptr_gate_in1 = ptr_gate;
-        m_layers[num_layer_input].m_gates[gate_in_uid].take_inv_output_in_in1 = take_inv_output;
-    }
-
-    //Update the vector containing info on the connections in the circuit
-    auto it_connections = find_if(m_connections.begin(), m_connections.end(),
-                                  [&](const connection& c) -> bool{
-                                      return c.m_uid_input == gate_in_uid && c.m_num_input == num_input;
-                                  });
-
-    if(it_connections != m_connections.end())
-        m_connections.erase(it_connections);
-    m_connections.emplace_back(gate_out_uid, take_inv_output, gate_in_uid, num_input);
+    connect_input(gate_index(gate_in_uid), num_input, gate_index(gate_out_uid), take_inv_output);
 
     return 0;
 }
@@ -223,16 +1100,15 @@ int circuit::delete_layer(const size_t& num_layer){
     if(num_layer == 0 || num_layer == static_cast<size_t>(-1))
         return 2;
 
+    //The gates are deleted from the last one, so that the others don't have to be moved in the layer
     vector<size_t> uids_gate_to_delete;
-    for(const auto& g : m_gates_in_layers){
-        if(g.second == num_layer)
-            uids_gate_to_delete.push_back(g.first);
-    }
+    for(const auto& i : m_layers[num_layer].m_indices)
+        uids_gate_to_delete.push_back(m_gate_uids[i]);
 
-    for(const auto& uid : uids_gate_to_delete)
-        delete_gate(uid);
+    for(auto it = uids_gate_to_delete.rbegin(); it != uids_gate_to_delete.rend(); ++it)
+        delete_gate(*it);
 
-    if(!m_layers[num_layer].m_gates.empty())
+    if(!m_layers[num_layer].m_indices.empty())
         return 3;
 
     m_layers.extract(num_layer);
@@ -241,65 +1117,43 @@ int circuit::delete_layer(const size_t& num_layer){
 
 //Delete a gate by just specifying its uid
 int circuit::delete_gate(const size_t& uid){
-    if(!m_gates_in_layers.contains(uid))
+    if(!m_gate_indices.contains(uid))
         return 1;
 
-    return delete_gate(uid, m_gates_in_layers[uid]);
+    return delete_gate(uid, layer_of(uid));
 }
 
 //Delete a gate by specifying its uid and the layer it's in
 int circuit::delete_gate(const size_t& uid, const size_t& num_layer){
-    if(!m_gates_in_layers.contains(uid))
+    if(!m_gate_indices.contains(uid))
         return 1;
     
-    if(m_gates_in_layers[uid] != num_layer)
+    if(layer_of(uid) != num_layer)
         return 2;
 
     if(num_layer == 0 || num_layer == static_cast<size_t>(-1))
         return 3;
     
-    //Delete all the connections first
-    for(auto it_conn = m_connections.begin(); it_conn < m_connections.end(); ++it_conn){
-        //If the connection specifies that the gate's input was connected somewhere, it's not a big deal
-        if(it_conn->m_uid_input == uid){
-            it_conn = m_connections.erase(it_conn);
-        }
-
-        //If the connection specifies that the gate's outpus was connected somewhere, then we have to set
-        //the other gates' pointer to nullptr
-        if(it_conn->m_uid_output == uid){
-            if(it_conn->m_num_input == 0)
-                m_layers[m_gates_in_layers[it_conn->m_uid_input]].m_gates[it_conn->m_uid_input].ptr_gate_in0 = nullptr;
-            if(it_conn->m_num_input == 1)
-                m_layers[m_gates_in_layers[it_conn->m_uid_input]].m_gates[it_conn->m_uid_input].ptr_gate_in1 = nullptr;
-
-            it_conn = m_connections.erase(it_conn);
-        }
-    }
-
-    //Delete the gate from the circuit
-    m_layers[num_layer].m_gates.extract(uid);
-
-    //Delete the information of the gate from "m_gates_in_layers"
-    m_gates_in_layers.extract(uid);
+    //Delete the gate from the circuit, together with all its connections
+    destroy_gate(gate_index(uid));
 
     return 0;
 }
 
 //Delete all the connections to a gate inputs by just specifying its uid
 int circuit::delete_connections_to_gate_inputs(const size_t& uid){
-    if(!m_gates_in_layers.contains(uid))
+    if(!m_gate_indices.contains(uid))
         return 1;
 
-    return delete_connections_to_gate_inputs(uid, m_gates_in_layers[uid]);
+    return delete_connections_to_gate_inputs(uid, layer_of(uid));
 }
 
 //Delete all the connections to a gate inputs by specifying its uid and the layer it's in
 int circuit::delete_connections_to_gate_inputs(const size_t& uid, const size_t& num_layer){
-    if(!m_gates_in_layers.contains(uid))
+    if(!m_gate_indices.contains(uid))
         return 1;
     
-    if(m_gates_in_layers[uid] != num_layer)
+    if(layer_of(uid) != num_layer)
         return 2;
 
     delete_connection(uid, 0);
@@ -310,30 +1164,26 @@ int circuit::delete_connections_to_gate_inputs(const size_t& uid, const size_t&
 
 //Delete all the connections from a gate's outputs by just specifying its uid
 int circuit::delete_connections_from_gate_outputs(const size_t& uid){
-    if(!m_gates_in_layers.contains(uid))
+    if(!m_gate_indices.contains(uid))
         return 1;
 
-    return delete_connections_from_gate_outputs(uid, m_gates_in_layers[uid]);
+    return delete_connections_from_gate_outputs(uid, layer_of(uid));
 }
 
 //Delete all the connections from a gate's outputs by specifying its uid and the layer it's in
 int circuit::delete_connections_from_gate_outputs(const size_t& uid, const size_t& num_layer){
-    if(!m_gates_in_layers.contains(uid))
+    if(!m_gate_indices.contains(uid))
         return 1;
     
-    if(m_gates_in_layers[uid] != num_layer)
+    if(layer_of(uid) != num_layer)
         return 2;
 
-    for(auto it_conn = m_connections.begin(); it_conn < m_connections.end(); ++it_conn){
-        if(it_conn->m_uid_output == uid){
-            if(it_conn->m_num_input == 0)
-                m_layers[m_gates_in_layers[it_conn->m_uid_input]].m_gates[it_conn->m_uid_input].ptr_gate_in0 = nullptr;
-            if(it_conn->m_num_input == 1)
-                m_layers[m_gates_in_layers[it_conn->m_uid_input]].m_gates[it_conn->m_uid_input].ptr_gate_in1 = nullptr;
+    const uint32_t index = gate_index(uid);
+    for(const auto& pin : m_fanouts[index])
+        (pin & 1 ? m_gates[pin >> 1].in1 : m_gates[pin >> 1].in0) = NO_GATE;
+    m_fanouts[index].clear();
+    m_compiled_stale = true;
 
-            it_conn = m_connections.erase(it_conn);
-        }
-    }
     return 0;
 }
 
@@ -349,19 +1199,10 @@ int circuit::delete_connections_to_and_from_gate(const size_t& uid, const size_t
 
 //Delete a connection to an input of a gate by just specifying the gate's uid and its input number
 int circuit::delete_connection(const size_t& gate_in_uid, const bool& num_input){
-    if(!m_gates_in_layers.contains(gate_in_uid))
+    if(!m_gate_indices.contains(gate_in_uid))
         return 1;
     
-    for(auto it_conn = m_connections.begin(); it_conn < m_connections.end(); ++it_conn){
-        if(it_conn->m_uid_input == gate_in_uid && it_conn->m_num_input == num_input){
-            if(num_input == 0)
-                m_layers[m_gates_in_layers[gate_in_uid]].m_gates[gate_in_uid].ptr_gate_in0 = nullptr;
-            if(num_input == 1)
-                m_layers[m_gates_in_layers[gate_in_uid]].m_gates[gate_in_uid].ptr_gate_in1 = nullptr;
-
-            it_conn = m_connections.erase(it_conn);
-        }
-    }
+    disconnect_input(gate_index(gate_in_uid), num_input);
 
     return 0;
 }
@@ -371,29 +1212,23 @@ int circuit::delete_connection(const size_t& gate_out_uid, const size_t& gate_in
 }
 
 int circuit::delete_connection(const size_t& gate_out_uid, const bool& take_inv_output, const size_t& gate_in_uid, const bool& num_input){
-    if(!m_gates_in_layers.contains(gate_in_uid) || !m_gates_in_layers.contains(gate_out_uid))
+    if(!m_gate_indices.contains(gate_in_uid) || !m_gate_indices.contains(gate_out_uid))
         return 1;
 
-    return delete_connection(m_gates_in_layers[gate_out_uid], gate_out_uid, take_inv_output, m_gates_in_layers[gate_in_uid], gate_in_uid, num_input);
+    return delete_connection(layer_of(gate_out_uid), gate_out_uid, take_inv_output, layer_of(gate_in_uid), gate_in_uid, num_input);
 }
 
 int circuit::delete_connection(const size_t& num_layer_output, const size_t& gate_out_uid, const bool& take_inv_output, const size_t& num_layer_input, const size_t& gate_in_uid, const bool& num_input){
-    if(!m_gates_in_layers.contains(gate_in_uid) || !m_gates_in_layers.contains(gate_out_uid))
+    if(!m_gate_indices.contains(gate_in_uid) || !m_gate_indices.contains(gate_out_uid))
         return 1;
 
-    if(m_gates_in_layers[gate_out_uid] != num_layer_output || m_gates_in_layers[gate_in_uid] != num_layer_input)
+    if(layer_of(gate_out_uid) != num_layer_output || layer_of(gate_in_uid) != num_layer_input)
         return 2;
 
-    for(auto it_conn = m_connections.begin(); it_conn < m_connections.end(); ++it_conn){
-        if(it_conn->m_uid_output == gate_out_uid && it_conn->m_inv_output == take_inv_output && it_conn->m_uid_input == gate_in_uid && it_conn->m_num_input == num_input){
-            if(num_input == 0)
-                m_layers[m_gates_in_layers[gate_in_uid]].m_gates[gate_in_uid].ptr_gate_in0 = nullptr;
-            if(num_input == 1)
-                m_layers[m_gates_in_layers[gate_in_uid]].m_gates[gate_in_uid].ptr_gate_in1 = nullptr;
-
-            it_conn = m_connections.erase(it_conn);
-        }
-    }
+    //The input is disconnected only if it's connected to the specified output
+    const gate& g = m_gates[gate_index(gate_in_uid)];
+    if((num_input ? g.in1 : g.in0) == gate_index(gate_out_uid) && (num_input ? g.inv_in1 : g.inv_in0) == take_inv_output)
+        disconnect_input(gate_index(gate_in_uid), num_input);
 
     return 0;
 }
@@ -401,104 +1236,1644 @@ int circuit::delete_connection(const size_t& num_layer_output, const size_t& gat
 //------------------------------------------------------------------------------------------------------------------------------------
 //Methods to interact with the inputs and outputs of the circuit
 
-//Set inputs to specified values
+//Set inputs to specified values. They're applied to the circuit on the next simulation
 int circuit::set_inputs(const vector<bool>& inputs){
     if(inputs.size() != m_inputs.size())
         return 1;
 
     m_inputs = inputs;
 
-    set_all_gates_to_status(status::to_update);
+    return 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------
+//Methods to simulate the circuit
 
-    //Set the first two gates to be constants false and true
-    m_layers[0].m_gates[0].output = false;
-    m_layers[0].m_gates[0].inv_output = true;
-    m_layers[0].m_gates[0].gate_status = status::updated;
-    m_layers[0].m_gates[1].output = true;
-    m_layers[0].m_gates[1].inv_output = false;
-    m_layers[0].m_gates[1].gate_status = status::updated;
+//Function to lower the circuit to its compiled form: a topologically ordered array of gate_ops streamed by the simulation
+//engines. It's rebuilt only if the circuit has been edited since the last compilation
+int circuit::compile(){
+    if(!m_compiled_stale)
+        return 0;
 
-    //Update all the other input gates
-    for(size_t i = 0; i < inputs.size(); ++i){
-        m_layers[0].m_gates[i + 2].output = m_inputs[i];
-        m_layers[0].m_gates[i + 2].inv_output = !m_inputs[i];
-        m_layers[0].m_gates[i + 2].gate_status = status::updated;
-    }
+    m_native.reset();
+    m_net_values_valid = false;
+    if(build_flat_netlist(m_compiled))
+        return 1;
+
+    m_net_values.assign(m_compiled.m_num_nets, 0);
+    m_op_scheduled.assign(m_compiled.m_ops.size(), false);
+    m_events.assign(m_compiled.m_layer_offsets.size() - 1, vector<uint32_t>());
+    m_first_event_layer = m_events.size();
+    m_last_event_layer = 0;
+    m_compiled_stale = false;
 
     return 0;
 }
 
-//Read outputs and return them in a vector of bools
-vector<bool> circuit::read_outputs(){
-    size_t output_index = 0;
+//Function to build a native evaluator for the compiled form of the circuit, which will then be used by all the
+//simulations until the circuit gets edited.
+//Returns 1 if the circuit can't be compiled, 2 if the native code can't be built (e.g. there's no compiler installed)
+//and 3 if it can't be loaded. In all these cases the simulations keep using the kernels
+int circuit::compile_native(){
+    if(compile())
+        return 1;
 
-    for(auto it_last_layer = m_layers[-1].m_gates.begin(); it_last_layer != m_layers[-1].m_gates.end(); ++it_last_layer){
-        m_outputs[output_index] = it_last_layer->second.output;
-        ++output_index;
+    auto evaluator = make_shared<native_evaluator>();
+    switch(evaluator->build(m_compiled.m_ops, m_compiled.m_output_nets, m_inputs.size())){
+        case 0:
+            m_native = evaluator;
+            return 0;
+        case 1:
+            return 2;
+        default:
+            return 3;
     }
-
-    return m_outputs;
 }
 
-//------------------------------------------------------------------------------------------------------------------------------------
-//Methods to simulate the circuit
-
 //Function to simulate the circuit while specifying some inputs
-int circuit::simulate_circuit(const vector<bool>& inputs){
+int circuit::simulate_circuit(const vector<bool>& inputs, const size_t& num_threads){
     if(set_inputs(inputs))
         return 1;
 
-    return simulate_circuit();
+    return simulate_circuit(num_threads);
 }
 
-//Function to simulate the circuit, layer by layer
-int circuit::simulate_circuit(){
-    for(auto& l : m_layers){
-        for(auto& g : l.second.m_gates)
-            if(g.second.calc_output()){
-                return 1;
+//Function to simulate the circuit by streaming its compiled form, which is rebuilt first if the circuit has been edited.
+//Every net is a whole word, all set or all cleared, so that the same kernels of the bit-parallel engine can be used.
+//In event-driven mode, after a first complete simulation only the gates affected by the inputs that changed are updated.
+//With more than one thread, the big layers of the circuit are split between the threads (see run_ops)
+int circuit::simulate_circuit(const size_t& num_threads){
+    if(compile())
+        return 1;
+
+    if(m_event_driven && m_net_values_valid && !m_native && num_threads <= 1){
+        simulate_events();
+
+        for(size_t i = 0; i < m_outputs.size(); ++i)
+            m_outputs[i] = m_net_values[m_compiled.m_output_nets[i]] & 1;
+
+        return 0;
+    }
+
+    m_net_values[0] = 0;
+    m_net_values[1] = ~uint64_t(0);
+    for(size_t i = 0; i < m_inputs.size(); ++i)
+        m_net_values[i + 2] = (m_inputs[i] ? ~uint64_t(0) : 0);
+
+    //The native evaluator only computes the outputs, the internal nets aren't updated
+    if(m_native){
+        vector<uint64_t> output_words(m_outputs.size());
+        m_native->eval(m_net_values.data() + 2, output_words.data(), 1);
+
+        for(size_t i = 0; i < m_outputs.size(); ++i)
+            m_outputs[i] = output_words[i] & 1;
+
+        m_net_values_valid = false;
+        return 0;
+    }
+
+    run_ops(m_net_values.data(), 1, num_threads);
+    m_net_values_valid = true;
+
+    for(size_t i = 0; i < m_outputs.size(); ++i)
+        m_outputs[i] = m_net_values[m_compiled.m_output_nets[i]] & 1;
+
+    return 0;
+}
+
+//Function to simulate the circuit on 64 input vectors at once.
+//Bit k of inputs[i] is the value of input i in the k-th vector, and in the same way bit k of outputs[j] will be the
+//value of output j for the k-th vector. What read_outputs returns isn't affected
+int circuit::simulate_circuit_64(const vector<uint64_t>& inputs, vector<uint64_t>& outputs){
+    return simulate_circuit_wide(inputs, outputs, 1);
+}
+
+//Function to simulate the circuit on 64 * words_per_net input vectors at once, using the selected kernel.
+//Every input and output is made of words_per_net consecutive words, so the words of input i are
+//inputs[i * words_per_net] to inputs[(i + 1) * words_per_net - 1], and the same goes for the outputs.
+//With more than one thread, the big layers of the circuit are split between the threads (see run_ops)
+int circuit::simulate_circuit_wide(const vector<uint64_t>& inputs, vector<uint64_t>& outputs, const size_t& words_per_net, const size_t& num_threads){
+    if(words_per_net == 0 || inputs.size() != m_inputs.size() * words_per_net)
+        return 1;
+
+    if(compile())
+        return 1;
+    const flat_netlist& fn = m_compiled;
+
+    vector<uint64_t> nets(fn.m_num_nets * words_per_net, 0);
+    fill(nets.begin() + words_per_net, nets.begin() + 2 * words_per_net, ~uint64_t(0));
+    copy(inputs.begin(), inputs.end(), nets.begin() + 2 * words_per_net);
+
+    outputs.resize(fn.m_output_nets.size() * words_per_net);
+    run_wide_pass(nets.data(), outputs.data(), words_per_net, num_threads);
+
+    return 0;
+}
+
+//Function to simulate a batch of input vectors, packed one after the other, writing the packed output vectors in a
+//buffer provided by the caller. Every input vector is made of input_words_per_vector() words, with input i in bit i % 64
+//of word i / 64, and the same goes for the output vectors, made of output_words_per_vector() words.
+//The vectors are transposed 64 at a time to feed the bit-parallel engine, and its buffers are kept between calls, so
+//nothing gets allocated for each vector
+int circuit::simulate_batch(span<const uint64_t> inputs, span<uint64_t> outputs, const size_t& num_vectors){
+    const size_t in_words = input_words_per_vector();
+    const size_t out_words = output_words_per_vector();
+    if(inputs.size() < num_vectors * in_words || outputs.size() < num_vectors * out_words)
+        return 1;
+
+    if(compile())
+        return 1;
+
+    const size_t words_per_net = BATCH_WORDS_PER_NET;
+    const size_t num_outputs = m_outputs.size();
+    m_batch_nets.resize(m_compiled.m_num_nets * words_per_net);
+    m_batch_outputs.resize(num_outputs * words_per_net);
+    fill(m_batch_nets.begin(), m_batch_nets.begin() + words_per_net, 0);
+    fill(m_batch_nets.begin() + words_per_net, m_batch_nets.begin() + 2 * words_per_net, ~uint64_t(0));
+
+    uint64_t block[64];
+    for(size_t first_vector = 0; first_vector < num_vectors; first_vector += 64 * words_per_net){
+        pack_vectors_in_nets(inputs, num_vectors, first_vector, m_batch_nets.data(), words_per_net);
+        run_wide_pass(m_batch_nets.data(), m_batch_outputs.data(), words_per_net);
+
+        //Transpose the outputs back in output vectors
+        for(size_t w = 0; w < words_per_net && first_vector + 64 * w < num_vectors; ++w){
+            const size_t first_vector_word = first_vector + 64 * w;
+
+            for(size_t b = 0; b < out_words; ++b){
+                for(size_t j = 0; j < 64; ++j)
+                    block[j] = (b * 64 + j < num_outputs ? m_batch_outputs[(b * 64 + j) * words_per_net + w] : 0);
+
+                transpose_64x64(block);
+                for(size_t v = 0; v < 64 && first_vector_word + v < num_vectors; ++v)
+                    outputs[(first_vector_word + v) * out_words + b] = block[v];
             }
+        }
+    }
+
+    return 0;
+}
+
+//Function to simulate the stuck-at faults of the circuit (see enumerate_faults) over a set of test vectors, packed
+//like in simulate_batch, reporting which of them detect each fault, i.e. make at least an output differ from the good
+//circuit.
+//The vectors are simulated 64 * FAULT_SIM_WORDS_PER_NET at a time: the good circuit once, and then every fault not
+//detected yet, propagating only its effects. Once a fault is detected it's dropped, and never simulated again.
+//The faults are split between the workers of the pool of the circuit (up to num_threads, see pool_workers).
+//Returns 1 if the buffer of the vectors is too small or if the circuit can't be compiled
+int circuit::simulate_faults(span<const uint64_t> inputs, const size_t& num_vectors, fault_sim_report& report, const size_t& num_threads){
+    if(inputs.size() < num_vectors * input_words_per_vector())
+        return 1;
+
+    if(compile())
+        return 1;
+
+    const flat_netlist& fn = m_compiled;
+    const size_t words_per_net = FAULT_SIM_WORDS_PER_NET;
+
+    vector<fault_target> targets;
+    enumerate_faults(report.faults, targets);
+    const size_t num_workers = pool_workers(num_threads, report.faults.size());
+    report.detecting_vectors.assign(report.faults.size(), FAULT_NOT_DETECTED);
+    report.num_detected = 0;
+
+    vector<uint8_t> is_output_net(fn.m_num_nets, false);
+    for(const auto& net : fn.m_output_nets)
+        is_output_net[net] = true;
+
+    vector<uint64_t> good_nets(fn.m_num_nets * words_per_net, 0);
+    fill(good_nets.begin() + words_per_net, good_nets.begin() + 2 * words_per_net, ~uint64_t(0));
+
+    vector<fault_workspace> workspaces(num_workers);
+    for(auto& ws : workspaces){
+        ws.m_op_scheduled.assign(fn.m_ops.size(), false);
+        ws.m_events.resize(fn.m_layer_offsets.size() - 1);
+    }
+
+    vector<size_t> undetected(report.faults.size());
+    for(size_t f = 0; f < undetected.size(); ++f)
+        undetected[f] = f;
+
+    for(size_t first_vector = 0; first_vector < num_vectors && !undetected.empty(); first_vector += 64 * words_per_net){
+        pack_vectors_in_nets(inputs, num_vectors, first_vector, good_nets.data(), words_per_net);
+        run_ops(good_nets.data(), words_per_net, num_threads);
+
+        uint64_t valid_lanes[words_per_net];
+        set_valid_lanes(first_vector, num_vectors, words_per_net, valid_lanes);
+
+        const size_t num_slices = (undetected.size() < num_workers ? 1 : num_workers);
+        auto simulate_faults_slice = [&](const size_t& worker){
+            fault_workspace& ws = workspaces[worker];
+            ws.m_faulty_nets = good_nets;
+
+            for(size_t k = worker; k < undetected.size(); k += num_slices){
+                const size_t f = undetected[k];
+                const size_t detecting_lane = propagate_fault(targets[f], good_nets.data(), valid_lanes, is_output_net, ws);
+                if(detecting_lane != FAULT_NOT_DETECTED)
+                    report.detecting_vectors[f] = first_vector + detecting_lane;
+            }
+        };
+
+        m_pool.run(num_slices, simulate_faults_slice);
+
+        //Drop the faults detected
+        erase_if(undetected, [&](const size_t& f){return report.detecting_vectors[f] != FAULT_NOT_DETECTED;});
+    }
+
+    report.num_detected = report.faults.size() - undetected.size();
+
+    return 0;
+}
+
+//Function to compute the SCOAP and COP testability measures of the output of every gate, without simulating any vector:
+//the controllabilities and the signal probabilities with a forward sweep over the compiled circuit, and then the
+//observabilities with a backward sweep. The results are indexed by the uid of the gates.
+//Returns 1 if the circuit can't be compiled
+int circuit::analyze_testability(map<size_t, gate_testability>& results){
+    if(compile())
+        return 1;
+
+    const flat_netlist& fn = m_compiled;
+    const uint32_t first_op_net = m_inputs.size() + 2;
+
+    auto add = [](const uint64_t& a, const uint64_t& b){return min(a + b, SCOAP_INFINITY);};
+    auto inverting = [](const gate_type& t){
+        return t == gate_type::not_gate || t == gate_type::nand_gate || t == gate_type::nor_gate || t == gate_type::nxor_gate;
+    };
+
+    vector<gate_testability> nets(fn.m_num_nets, gate_testability{SCOAP_INFINITY, SCOAP_INFINITY, SCOAP_INFINITY, 0.0, 0.0});
+    nets[0].cc0 = 1;
+    nets[1].cc1 = 1;
+    nets[1].p1 = 1.0;
+    for(uint32_t net = 2; net < first_op_net; ++net)
+        nets[net] = gate_testability{1, 1, SCOAP_INFINITY, 0.5, 0.0};
+
+    //Function to get the controllabilities and the signal probability seen by an input of an op, after the inversion
+    //of the connection
+    auto input_measures = [&](const uint32_t& net, const bool& inv, uint64_t& c0, uint64_t& c1, double& p){
+        c0 = (inv ? nets[net].cc1 : nets[net].cc0);
+        c1 = (inv ? nets[net].cc0 : nets[net].cc1);
+        p = (inv ? 1.0 - nets[net].p1 : nets[net].p1);
+    };
+
+    //Forward sweep: controllabilities and signal probabilities
+    for(const auto& op : fn.m_ops){
+        uint64_t a0, a1, b0, b1, c0, c1;
+        double pa, pb, p;
+        input_measures(op.net_in0, op.inv_in0, a0, a1, pa);
+        input_measures(op.net_in1, op.inv_in1, b0, b1, pb);
+
+        switch(op.type){
+            case gate_type::buffer:
+            case gate_type::not_gate:
+                c0 = add(a0, 1);
+                c1 = add(a1, 1);
+                p = pa;
+                break;
+
+            case gate_type::and_gate:
+            case gate_type::nand_gate:
+                c0 = add(min(a0, b0), 1);
+                c1 = add(add(a1, b1), 1);
+                p = pa * pb;
+                break;
+
+            case gate_type::or_gate:
+            case gate_type::nor_gate:
+                c0 = add(add(a0, b0), 1);
+                c1 = add(min(a1, b1), 1);
+                p = pa + pb - pa * pb;
+                break;
+
+            default:
+                c0 = add(min(add(a0, b0), add(a1, b1)), 1);
+                c1 = add(min(add(a0, b1), add(a1, b0)), 1);
+                p = pa + pb - 2.0 * pa * pb;
+                break;
+        }
+
+        if(inverting(op.type)){
+            swap(c0, c1);
+            p = 1.0 - p;
+        }
+
+        nets[op.net_out].cc0 = c0;
+        nets[op.net_out].cc1 = c1;
+        nets[op.net_out].p1 = p;
+    }
+
+    //Backward sweep: observabilities. The ops are visited in reverse order, so the observability of a net is complete
+    //when the op driving it is visited. For the COP observability, the fanout branches are assumed independent
+    for(const auto& net : fn.m_output_nets){
+        nets[net].co = 0;
+        nets[net].obs = 1.0;
+    }
+
+    auto observe_input = [&](const uint32_t& net, const uint64_t& co, const double& obs){
+        nets[net].co = min(nets[net].co, co);
+        nets[net].obs = 1.0 - (1.0 - nets[net].obs) * (1.0 - obs);
+    };
+
+    for(size_t i = fn.m_ops.size(); i-- > 0;){
+        const gate_op& op = fn.m_ops[i];
+        const gate_testability out = nets[op.net_out];
+        if(out.co >= SCOAP_INFINITY)
+            continue;
+
+        uint64_t a0, a1, b0, b1;
+        double pa, pb;
+        input_measures(op.net_in0, op.inv_in0, a0, a1, pa);
+        input_measures(op.net_in1, op.inv_in1, b0, b1, pb);
+
+        switch(op.type){
+            case gate_type::buffer:
+            case gate_type::not_gate:
+                observe_input(op.net_in0, add(out.co, 1), out.obs);
+                break;
+
+            case gate_type::and_gate:
+            case gate_type::nand_gate:
+                observe_input(op.net_in0, add(add(out.co, b1), 1), out.obs * pb);
+                observe_input(op.net_in1, add(add(out.co, a1), 1), out.obs * pa);
+                break;
+
+            case gate_type::or_gate:
+            case gate_type::nor_gate:
+                observe_input(op.net_in0, add(add(out.co, b0), 1), out.obs * (1.0 - pb));
+                observe_input(op.net_in1, add(add(out.co, a0), 1), out.obs * (1.0 - pa));
+                break;
+
+            default:
+                observe_input(op.net_in0, add(add(out.co, min(b0, b1)), 1), out.obs);
+                observe_input(op.net_in1, add(add(out.co, min(a0, a1)), 1), out.obs);
+                break;
+        }
+    }
+
+    results.clear();
+    for(uint32_t net = 0; net < fn.m_num_nets; ++net)
+        results.emplace(fn.m_net_uids[net], nets[net]);
+
+    return 0;
+}
+
+//Function to build the BDDs of the outputs of the circuit in a BDD manager, where variable i is input i of the circuit.
+//The BDDs of the nets are built following the compiled ops, and each of them is dereferenced after its last reader is
+//built, so that only the BDDs of the outputs remain referenced: they're returned in outputs, and the caller has to
+//dereference them when they aren't needed anymore. If reorder is true the variables are sifted whenever the nodes have
+//doubled since the last reordering, starting from BDD_FIRST_REORDER_NODES, and once more at the end.
+//Returns 1 if the circuit can't be compiled, 2 if the manager has less variables than the inputs of the circuit, and 3 if
+//the manager runs out of nodes
+int circuit::build_output_bdds(bdd_manager& manager, vector<uint32_t>& outputs, const bool& reorder){
+    if(compile())
+        return 1;
+
+    if(manager.num_vars() < m_inputs.size())
+        return 2;
+
+    const flat_netlist& fn = m_compiled;
+    const uint32_t first_op_net = m_inputs.size() + 2;
+
+    //The readers left for each net, after which its BDD is dereferenced. The outputs count as an extra reader, which
+    //is left to the caller
+    vector<uint32_t> nets(fn.m_num_nets);
+    vector<uint32_t> readers_left(fn.m_num_nets);
+    for(uint32_t net = 0; net < fn.m_num_nets; ++net)
+        readers_left[net] = fn.m_fanout_offsets[net + 1] - fn.m_fanout_offsets[net];
+    for(const auto& net : fn.m_output_nets)
+        ++readers_left[net];
+
+    auto keep = [&](const uint32_t& net, const uint32_t& f){
+        nets[net] = f;
+        if(readers_left[net] > 0)
+            manager.ref(f);
+    };
+    auto release = [&](const uint32_t& net){
+        if(--readers_left[net] == 0)
+            manager.deref(nets[net]);
+    };
+
+    nets[0] = BDD_FALSE;
+    nets[1] = BDD_TRUE;
+    for(uint32_t net = 2; net < first_op_net; ++net)
+        keep(net, manager.var(net - 2));
+
+    size_t reorder_nodes = BDD_FIRST_REORDER_NODES;
+
+    for(const auto& op : fn.m_ops){
+        const uint32_t result = apply_bdd_op(manager, op, nets[op.net_in0], nets[op.net_in1]);
+        if(manager.overflowed())
+            return 3;
+
+        keep(op.net_out, result);
+        if(op.net_in0 > 1)
+            release(op.net_in0);
+        if(op.net_in1 > 1 && op.net_in1 != op.net_in0)
+            release(op.net_in1);
+
+        if(reorder && manager.num_nodes() > reorder_nodes){
+            manager.reorder();
+            reorder_nodes = max(reorder_nodes, 2 * manager.num_nodes());
+        }
+    }
+
+    outputs.clear();
+    for(const auto& net : fn.m_output_nets)
+        outputs.push_back(nets[net]);
+
+    if(reorder)
+        manager.reorder();
+    else
+        manager.collect_garbage();
+
+    return 0;
+}
+
+//Function to estimate the probability of each output, and of the output of each gate, being 1, by simulating num_samples
+//uniformly random input vectors and counting how many times they're 1.
+//The vectors are simulated 64 * SAMPLING_WORDS_PER_NET at a time, and the passes are split between the workers of the
+//pool of the circuit (up to num_threads, see pool_workers), each with its own nets and counters. The inputs of each pass are drawn from a generator seeded with the seed and the
+//index of the pass, so the result only depends on the seed, and not on the number of threads.
+//Returns 1 if the circuit can't be compiled
+int circuit::sample_signal_probabilities(const uint64_t& num_samples, const uint64_t& seed, sampling_report& report, const size_t& num_threads){
+    if(compile())
+        return 1;
+
+    const flat_netlist& fn = m_compiled;
+    const size_t words_per_net = SAMPLING_WORDS_PER_NET;
+    const uint64_t samples_per_pass = 64 * words_per_net;
+    const uint64_t num_passes = (num_samples + samples_per_pass - 1) / samples_per_pass;
+    const size_t num_workers = pool_workers(num_threads, num_passes);
+    const size_t num_inputs = m_inputs.size();
+
+    vector<vector<uint64_t>> worker_ones(num_workers, vector<uint64_t>(fn.m_num_nets, 0));
+
+    auto sample_passes = [&](const size_t& worker){
+        vector<uint64_t> nets(fn.m_num_nets * words_per_net, 0);
+        fill(nets.begin() + words_per_net, nets.begin() + 2 * words_per_net, ~uint64_t(0));
+        vector<uint64_t>& ones = worker_ones[worker];
+        const count_fn count_ones = get_count_kernel();
+
+        for(uint64_t pass = worker; pass < num_passes; pass += num_workers){
+            random_words generator(seed ^ (pass * 0xD1B54A32D192ED03));
+            for(size_t w = 2 * words_per_net; w < (num_inputs + 2) * words_per_net; ++w)
+                nets[w] = generator.next();
+
+            run_ops(nets.data(), words_per_net, 1);
+
+            //Only the first num_samples lanes are counted, in the last pass
+            uint64_t valid_lanes[words_per_net];
+            set_valid_lanes(pass * samples_per_pass, num_samples, words_per_net, valid_lanes);
+
+            count_ones(nets.data(), fn.m_num_nets, words_per_net, valid_lanes, ones.data());
+        }
+    };
+
+    m_pool.run(num_workers, sample_passes);
+
+    for(size_t w = 1; w < num_workers; ++w){
+        for(uint32_t net = 0; net < fn.m_num_nets; ++net)
+            worker_ones[0][net] += worker_ones[w][net];
+    }
+
+    report.num_samples = num_samples;
+    report.output_ones.clear();
+    for(const auto& net : fn.m_output_nets)
+        report.output_ones.push_back(worker_ones[0][net]);
+    report.gate_ones.clear();
+    for(uint32_t net = 0; net < fn.m_num_nets; ++net)
+        report.gate_ones.emplace(fn.m_net_uids[net], worker_ones[0][net]);
+
+    return 0;
+}
+
+//Function to count how many times the output of every gate toggles between consecutive vectors of a set of input
+//vectors, packed like in simulate_batch, and sum the toggles of every layer and of every type of gate.
+//The vectors are simulated 64 * ACTIVITY_WORDS_PER_NET at a time, and the toggles are counted comparing every lane of a
+//net with the previous one (see get_toggle_count_kernel). The vectors are split in contiguous ranges, one for each worker
+//of the pool of the circuit (up to num_threads, see pool_workers), each simulated starting from the last vector of the
+//previous range, whose lane isn't counted.
+//Returns 1 if the buffer of the vectors is too small or if the circuit can't be compiled
+int circuit::simulate_switching_activity(span<const uint64_t> inputs, const size_t& num_vectors, switching_activity_report& report, const size_t& num_threads){
+    if(inputs.size() < num_vectors * input_words_per_vector())
+        return 1;
+
+    if(compile())
+        return 1;
+
+    const flat_netlist& fn = m_compiled;
+    const size_t words_per_net = ACTIVITY_WORDS_PER_NET;
+    const size_t vectors_per_pass = 64 * words_per_net;
+    const size_t num_workers = pool_workers(num_threads, num_vectors / vectors_per_pass);
+
+    vector<vector<uint64_t>> worker_toggles(num_workers, vector<uint64_t>(fn.m_num_nets, 0));
+
+    auto count_range = [&](const size_t& worker){
+        const size_t first_vector = num_vectors * worker / num_workers;
+        const size_t last_vector = num_vectors * (worker + 1) / num_workers;
+        const toggle_count_fn count_toggles = get_toggle_count_kernel();
+
+        vector<uint64_t> nets(fn.m_num_nets * words_per_net, 0);
+        fill(nets.begin() + words_per_net, nets.begin() + 2 * words_per_net, ~uint64_t(0));
+        vector<uint64_t> last_lanes(fn.m_num_nets, 0);
+        vector<uint64_t>& toggles = worker_toggles[worker];
+
+        //The first vector simulated has no previous one, so its lane is never counted
+        const size_t first_simulated = (first_vector == 0 ? 0 : first_vector - 1);
+        for(size_t first_pass_vector = first_simulated; first_pass_vector < last_vector; first_pass_vector += vectors_per_pass){
+            pack_vectors_in_nets(inputs, last_vector, first_pass_vector, nets.data(), words_per_net);
+            run_ops(nets.data(), words_per_net, 1);
+
+            uint64_t valid_lanes[words_per_net];
+            set_valid_lanes(first_pass_vector, last_vector, words_per_net, valid_lanes);
+            if(first_pass_vector == first_simulated)
+                valid_lanes[0] &= ~uint64_t(1);
+
+            count_toggles(nets.data(), fn.m_num_nets, words_per_net, valid_lanes, last_lanes.data(), toggles.data());
+        }
+    };
+
+    m_pool.run(num_workers, count_range);
+
+    for(size_t w = 1; w < num_workers; ++w){
+        for(uint32_t net = 0; net < fn.m_num_nets; ++net)
+            worker_toggles[0][net] += worker_toggles[w][net];
+    }
+
+    report.num_vectors = num_vectors;
+    report.total_toggles = 0;
+    report.gate_toggles.clear();
+    report.layer_toggles.clear();
+    report.type_toggles.clear();
+    for(uint32_t net = 0; net < fn.m_num_nets; ++net){
+        const size_t uid = fn.m_net_uids[net];
+        const uint32_t index = gate_index(uid);
+        const uint64_t toggles = worker_toggles[0][net];
+
+        report.total_toggles += toggles;
+        report.gate_toggles.emplace(uid, toggles);
+        report.layer_toggles[m_gate_layers[index]] += toggles;
+        report.type_toggles[m_gates[index].type] += toggles;
+    }
+
+    return 0;
+}
+
+//Function to simulate the input vectors of a stimulus read from a stream, "printing" the outputs for each of them on the
+//specified ostream. Each line of the stimulus is an input vector written like the argument of the "si" command, and
+//produces a line with the outputs like the "ro" command. Empty lines and lines starting with '#' are skipped.
+//The stream is read in chunks of STIMULUS_CHUNK_SIZE bytes, parsed in place.
+//Returns 1 if the stream can't be read, 2 if the circuit can't be compiled and 3 if a line of the stimulus isn't a valid
+//input vector. num_lines is set to the number of lines read, so in the last case it's the number of the invalid line
+int circuit::simulate_stimulus(istream& is, ostream& os, size_t& num_lines){
+    num_lines = 0;
+
+    if(!is)
+        return 1;
+
+    if(compile())
+        return 2;
+
+    async_writer<string> writer(os);
+    vector<char> buffer(STIMULUS_CHUNK_SIZE);
+    size_t carried_bytes = 0;
+    while(true){
+        is.read(buffer.data() + carried_bytes, buffer.size() - carried_bytes);
+        const size_t available_bytes = carried_bytes + is.gcount();
+        const bool last_chunk = !is;
+
+        const char* text = buffer.data();
+        const int ret_val = simulate_stimulus_text(text, buffer.data() + available_bytes, last_chunk, writer, num_lines);
+        if(ret_val != 0 || last_chunk)
+            return ret_val;
+
+        //Move the incomplete line at the end of the chunk to the start of the buffer, which is enlarged if that line
+        //fills it entirely
+        carried_bytes = buffer.data() + available_bytes - text;
+        const size_t first_carried_byte = text - buffer.data();
+        if(carried_bytes == buffer.size())
+            buffer.resize(buffer.size() * 2);
+        copy(buffer.begin() + first_carried_byte, buffer.begin() + first_carried_byte + carried_bytes, buffer.begin());
+    }
+}
+
+//Function to simulate the input vectors of a stimulus file, like simulate_stimulus. The file is memory-mapped and
+//parsed in place, unless it can't be mapped (e.g. it's a pipe), in which case it's read as a stream
+int circuit::simulate_stimulus_file(const string& filename, ostream& os, size_t& num_lines){
+    num_lines = 0;
+
+    mapped_file file;
+    switch(file.open(filename)){
+        case 0:
+            break;
+
+        case 2: {
+            ifstream is(filename, ios::binary);
+            return simulate_stimulus(is, os, num_lines);
+        }
+
+        default:
+            return 1;
     }
 
-    return 0;    
+    if(compile())
+        return 2;
+
+    async_writer<string> writer(os);
+    const char* text = file.data();
+    return simulate_stimulus_text(text, file.data() + file.size(), true, writer, num_lines);
+}
+
+//Function to read all the input vectors of a stimulus file, written like for simulate_stimulus, packing them one after
+//the other in inputs like simulate_batch wants them.
+//Returns 1 if the file can't be opened and 3 if a line of the stimulus isn't a valid input vector. num_lines is set to
+//the number of lines read, so in the last case it's the number of the invalid line
+int circuit::load_stimulus_file(const string& filename, vector<uint64_t>& inputs, size_t& num_vectors, size_t& num_lines) const {
+    const size_t in_words = input_words_per_vector();
+    num_vectors = 0;
+    num_lines = 0;
+    inputs.clear();
+
+    mapped_file file;
+    if(file.open(filename))
+        return 1;
+
+    const char* text = file.data();
+    const char* text_end = file.data() + file.size();
+    while(text < text_end){
+        const char* line_end = static_cast<const char*>(memchr(text, '\n', text_end - text));
+        if(line_end == nullptr)
+            line_end = text_end;
+
+        ++num_lines;
+        const char* content_end = (line_end > text && line_end[-1] == '\r' ? line_end - 1 : line_end);
+
+        if(content_end != text && *text != '#'){
+            inputs.resize((num_vectors + 1) * in_words);
+            if(parse_stimulus_line(text, content_end, inputs.data() + num_vectors * in_words))
+                return 3;
+
+            ++num_vectors;
+        }
+
+        text = (line_end == text_end ? text_end : line_end + 1);
+    }
+
+    return 0;
+}
+
+//Function to force the kernel used by the bit-parallel simulation engine, mainly for benchmarking.
+//With sim_kernel::automatic the widest kernel supported by the CPU is used
+int circuit::set_sim_kernel(const sim_kernel& k){
+    if(!kernel_supported(k))
+        return 1;
+
+    m_kernel = k;
+    return 0;
 }
 
 //Function to repeatedly simulate the circuit with every possible input, generating the truth table,
-//and "printing" the specified results on the specified ostream
-int circuit::gen_truth_table(ostream& os){
-    auto inputs_to_restore = m_inputs;
-    auto outputs_to_restore = m_outputs;
+//and "printing" the specified results on the specified ostream.
+//The rows are split in blocks, which the workers (up to num_threads, see pool_workers) take one after the other and
+//simulate and format with their own nets. The blocks are then printed in order by a writer thread (see async_writer)
+//while the next ones are simulated, so the result doesn't depend on the number of threads.
+//Returns 1 if the circuit can't be compiled, 2 if it has too many inputs to enumerate all their combinations
+int circuit::gen_truth_table(ostream& os, const size_t& num_threads){
+    if(compile())
+        return 1;
 
-    vector<bool> current_input = vector<bool>(m_inputs.size(), 0);
+    if(m_inputs.size() >= 64)
+        return 2;
 
-    do{
-        set_inputs(current_input);
-        
-        if(simulate_circuit())
+    const uint64_t num_rows = uint64_t(1) << m_inputs.size();
+    const uint64_t rows_per_block = min<uint64_t>(num_rows, TRUTH_TABLE_ROWS_PER_BLOCK);
+    const uint64_t num_blocks = num_rows / rows_per_block;
+
+    async_writer<string> writer(os);
+    atomic<uint64_t> next_block(0);
+    block_turns turns;
+    m_pool.run(pool_workers(num_threads, num_blocks), [&](const size_t&){
+        for(uint64_t block = next_block++; block < num_blocks; block = next_block++){
+            string text = writer.get_buffer();
+            text.clear();
+            format_truth_table_rows(block * rows_per_block, rows_per_block, text);
+
+            //The blocks are written while the next ones are being formatted
+            turns.in_turn(block, [&](){writer.write(move(text));});
+        }
+    });
+    writer.close();
+
+    return 0;
+}
+
+//Function to generate the truth table like gen_truth_table, but enumerating the inputs in Gray-code order, so that
+//exactly one input changes from a row to the next, and simulating event-driven only the fanout cone of that input.
+//The rows are enumerated in blocks of TRUTH_TABLE_ROWS_PER_BLOCK, each of them buffered and printed in natural binary
+//order by a writer thread, so the result is identical to gen_truth_table's.
+//This beats the bit-parallel engine on deep circuits where every input reaches only a small part of the gates
+int circuit::gen_truth_table_gray(ostream& os){
+    if(compile())
+        return 1;
+
+    if(m_inputs.size() >= 64)
+        return 2;
+
+    const size_t num_inputs = m_inputs.size();
+    const size_t num_outputs = m_outputs.size();
+    const uint64_t num_rows = uint64_t(1) << num_inputs;
+    const uint64_t rows_per_block = min<uint64_t>(num_rows, TRUTH_TABLE_ROWS_PER_BLOCK);
+    const size_t row_length = num_inputs + 3 + num_outputs + 1;
+
+    //Start from a complete simulation of the first row, with all the inputs set to 0
+    m_net_values[0] = 0;
+    m_net_values[1] = ~uint64_t(0);
+    fill(m_net_values.begin() + 2, m_net_values.begin() + 2 + num_inputs, 0);
+    run_ops(m_net_values.data(), 1, 1);
+    m_net_values_valid = true;
+
+    async_writer<string> writer(os);
+    uint64_t current_row = 0;
+    for(uint64_t first_row = 0; first_row < num_rows; first_row += rows_per_block){
+        //The buffers given back by the writer already contain the separators of the rows
+        string text = writer.get_buffer();
+        if(text.size() != rows_per_block * row_length){
+            text.assign(rows_per_block * row_length, ' ');
+            for(uint64_t r = 0; r < rows_per_block; ++r){
+                text[r * row_length + num_inputs + 1] = '|';
+                text[(r + 1) * row_length - 1] = '\n';
+            }
+        }
+
+        for(uint64_t k = 0; k < rows_per_block; ++k){
+            const uint64_t row = first_row + (k ^ (k >> 1));
+
+            //Flip the inputs that differ from the previous row: only one, except when moving to the next block
+            for(uint64_t changed_inputs = row ^ current_row; changed_inputs != 0; changed_inputs &= changed_inputs - 1){
+                const size_t i = countr_zero(changed_inputs);
+                m_net_values[i + 2] = ~m_net_values[i + 2];
+                schedule_fanout(i + 2);
+            }
+            propagate_events();
+            current_row = row;
+
+            char* row_text = text.data() + (row - first_row) * row_length;
+            for(size_t i = 0; i < num_inputs; ++i)
+                row_text[i] = '0' + ((row >> i) & 1);
+            for(size_t j = 0; j < num_outputs; ++j)
+                row_text[num_inputs + 3 + j] = '0' + (m_net_values[m_compiled.m_output_nets[j]] & 1);
+        }
+
+        writer.write(move(text));
+    }
+    writer.close();
+
+    return 0;
+}
+
+//Function to parse the line of a stimulus in [text, text_end), without the line terminator, in an input vector packed
+//like in simulate_batch.
+//Returns 1 if the line isn't made of exactly one '0' or '1' for each input
+int circuit::parse_stimulus_line(const char* text, const char* text_end, uint64_t* vector_inputs) const {
+    const size_t num_inputs = m_inputs.size();
+
+    if(size_t(text_end - text) != num_inputs)
+        return 1;
+
+    fill(vector_inputs, vector_inputs + input_words_per_vector(), 0);
+    for(size_t i = 0; i < num_inputs; ++i){
+        if(text[i] != '0' && text[i] != '1')
             return 1;
 
-        for(const auto& b : current_input)
-            os << b;
-        os << " | ";
+        vector_inputs[i / 64] |= uint64_t(text[i] - '0') << (i % 64);
+    }
+
+    return 0;
+}
 
-        for(const auto& b : read_outputs())
-            os << b;
-        os << endl;
+//Function to simulate the complete lines of a stimulus in [text, text_end), or all of them if this is the last chunk of
+//the stimulus. The vectors are packed and simulated in batches of STIMULUS_VECTORS_PER_BATCH, and the outputs of each
+//batch are formatted in a buffer handed over to the writer thread.
+//text is moved past the lines consumed, num_lines is incremented for each of them.
+//Returns 3 if a line isn't a valid input vector. The circuit must have been compiled already
+int circuit::simulate_stimulus_text(const char*& text, const char* text_end, const bool& last_chunk, async_writer<string>& writer, size_t& num_lines){
+    const size_t num_outputs = m_outputs.size();
+    const size_t in_words = input_words_per_vector();
+    const size_t out_words = output_words_per_vector();
+
+    vector<uint64_t> inputs(STIMULUS_VECTORS_PER_BATCH * in_words);
+    vector<uint64_t> outputs(STIMULUS_VECTORS_PER_BATCH * out_words);
+    size_t num_vectors = 0;
+
+    auto flush_batch = [&](){
+        if(num_vectors == 0)
+            return;
+
+        simulate_batch(span<const uint64_t>(inputs.data(), num_vectors * in_words), span<uint64_t>(outputs.data(), num_vectors * out_words), num_vectors);
+
+        string outputs_text = writer.get_buffer();
+        outputs_text.resize(num_vectors * (num_outputs + 1));
+        for(size_t v = 0; v < num_vectors; ++v){
+            char* row_text = outputs_text.data() + v * (num_outputs + 1);
+            const uint64_t* vector_outputs = outputs.data() + v * out_words;
+            for(size_t j = 0; j < num_outputs; ++j)
+                row_text[j] = '0' + ((vector_outputs[j / 64] >> (j % 64)) & 1);
+            row_text[num_outputs] = '\n';
+        }
 
-        bool increment_next_bit = true;
-        for(size_t i = 0; increment_next_bit && i < current_input.size(); ++i){
-            if(current_input[i] == 0){
-                current_input[i] = 1;
-                increment_next_bit = false;
+        writer.write(move(outputs_text));
+        num_vectors = 0;
+    };
+
+    while(text < text_end){
+        const char* line_end = static_cast<const char*>(memchr(text, '\n', text_end - text));
+        if(line_end == nullptr){
+            if(!last_chunk)
+                break;
+
+            line_end = text_end;
+        }
+
+        ++num_lines;
+        const char* content_end = (line_end > text && line_end[-1] == '\r' ? line_end - 1 : line_end);
+
+        if(content_end != text && *text != '#'){
+            if(parse_stimulus_line(text, content_end, inputs.data() + num_vectors * in_words)){
+                flush_batch();
+                return 3;
             }
-            else{
-                current_input[i] = 0;
-                increment_next_bit = 1;
+
+            if(++num_vectors == STIMULUS_VECTORS_PER_BATCH)
+                flush_batch();
+        }
+
+        text = (line_end == text_end ? text_end : line_end + 1);
+    }
+
+    flush_batch();
+    return 0;
+}
+
+//Function to generate the truth table like gen_truth_table, but writing it on the specified ostream in the binary
+//format of packed_truth_table_header, with one bit for each output in each row. The ostream should be opened in binary
+//mode. The blocks of rows are simulated by the workers of the pool of the circuit (up to num_threads, see pool_workers)
+//like in gen_truth_table, and the result doesn't depend on their number.
+//Returns 1 if the circuit can't be compiled, 2 if it has too many inputs to enumerate all their combinations and 3 if
+//the ostream fails (e.g. the disk is full), in which case the truth table written is incomplete
+int circuit::gen_truth_table_packed(ostream& os, const size_t& num_threads){
+    if(compile())
+        return 1;
+
+    if(m_inputs.size() >= 64)
+        return 2;
+
+    const uint64_t num_rows = uint64_t(1) << m_inputs.size();
+    const uint64_t rows_per_block = min<uint64_t>(num_rows, TRUTH_TABLE_ROWS_PER_BLOCK);
+    const uint64_t num_blocks = num_rows / rows_per_block;
+    const size_t words_per_block = m_outputs.size() * ((rows_per_block + 63) / 64);
+
+    packed_truth_table_header header{};
+    copy_n(PACKED_TRUTH_TABLE_MAGIC, sizeof(header.magic), header.magic);
+    header.version = PACKED_TRUTH_TABLE_VERSION;
+    header.num_inputs = m_inputs.size();
+    header.num_outputs = m_outputs.size();
+    header.rows_per_block = rows_per_block;
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    async_writer<vector<uint64_t>> writer(os);
+    atomic<uint64_t> next_block(0);
+    block_turns turns;
+    m_pool.run(pool_workers(num_threads, num_blocks), [&](const size_t&){
+        for(uint64_t block = next_block++; block < num_blocks; block = next_block++){
+            vector<uint64_t> columns = writer.get_buffer();
+            columns.resize(words_per_block);
+            pack_truth_table_rows(block * rows_per_block, rows_per_block, columns.data());
+
+            //The blocks are written while the next ones are being simulated
+            turns.in_turn(block, [&](){writer.write(move(columns));});
+        }
+    });
+    writer.close();
+
+    return os ? 0 : 3;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------
+//Methods to optimize the circuit
+
+//Function to simplify the circuit without changing the function of its outputs, removing:
+//- the gates whose output is constant, because of the constants 0 and 1 of the input layer (e.g. an AND with an input
+//  at 0) or of their own structure (e.g. an XOR of a signal with itself)
+//- the gates whose output is equal to one of their inputs or its inverse (e.g. buffers, NOT gates, or an AND with an
+//  input at 1), whose readers are connected directly to that input, taking its inverted output if needed
+//- the gates that don't reach any output of the circuit
+//The constants are propagated with a single pass over the layers in order, since every gate only reads gates of
+//previous layers. The output buffers are never removed, but their inputs can be connected to the constants.
+//Returns 1 if some gates have their inputs not connected
+int circuit::optimize(optimization_report& report){
+    if(compile())
+        return 1;
+
+    //A signal is the output of a gate, possibly inverted. The constants are always the non inverted outputs of the gates
+    //0 and 1 (at the indices 0 and 1), so that two signals are equal if and only if they have the same gate and inversion
+    struct signal{
+        uint32_t m_index;
+        bool m_inv;
+
+        bool operator==(const signal& other) const {return m_index == other.m_index && m_inv == other.m_inv;}
+    };
+
+    auto is_constant = [](const signal& s){return s.m_index <= 1;};
+    auto invert = [](const signal& s){return s.m_index <= 1 ? signal{1 - s.m_index, false} : signal{s.m_index, !s.m_inv};};
+    const signal zero{0, false};
+    const signal one{1, false};
+
+    //Function to compute the output of a gate of the specified type from the signals at its inputs, if it can be
+    //expressed as a constant or one of the signals. Returns false otherwise
+    auto fold = [&](const gate_type& type, const signal& a, const signal& b, signal& result){
+        bool inverting = false;
+        switch(type){
+            case gate_type::nand_gate:
+                inverting = true;
+                [[fallthrough]];
+            case gate_type::and_gate:
+                if(a == zero || b == zero || a == invert(b))
+                    result = zero;
+                else if(a == one || a == b)
+                    result = b;
+                else if(b == one)
+                    result = a;
+                else
+                    return false;
+                break;
+
+            case gate_type::not_gate:
+            case gate_type::nor_gate:
+                inverting = true;
+                [[fallthrough]];
+            case gate_type::buffer:
+            case gate_type::or_gate:
+                if(a == one || b == one || a == invert(b))
+                    result = one;
+                else if(a == zero || a == b)
+                    result = b;
+                else if(b == zero)
+                    result = a;
+                else
+                    return false;
+                break;
+
+            default:
+                inverting = (type == gate_type::nxor_gate);
+                if(a == b)
+                    result = zero;
+                else if(a == invert(b))
+                    result = one;
+                else if(is_constant(a))
+                    result = (a == one ? invert(b) : b);
+                else if(is_constant(b))
+                    result = (b == one ? invert(a) : a);
+                else
+                    return false;
+                break;
+        }
+
+        if(inverting)
+            result = invert(result);
+        return true;
+    };
+
+    report = optimization_report();
+    report.num_gates_before = num_gates();
+
+    //Forward pass: the signal equal to the output of every gate, which is the gate itself if it can't be simplified
+    vector<signal> signals(m_gates.size());
+    for(const auto& i : m_layers[0].m_indices)
+        signals[i] = signal{i, false};
+
+    for(auto& l : m_layers){
+        if(l.first == 0)
+            continue;
+
+        for(const auto& index : l.second.m_indices){
+            gate& g = m_gates[index];
+
+            //The inputs are connected to the simplified signals. Buffers and NOT gates with a single input connected
+            //read it from both inputs, like in the compiled form
+            signal in[2];
+            uint32_t* gate_in[2] = {&g.in0, &g.in1};
+            bool* inv_in[2] = {&g.inv_in0, &g.inv_in1};
+            for(size_t i = 0; i < 2; ++i){
+                if(*gate_in[i] == NO_GATE)
+                    continue;
+
+                in[i] = signals[*gate_in[i]];
+                if(*inv_in[i])
+                    in[i] = invert(in[i]);
+
+                *gate_in[i] = in[i].m_index;
+                *inv_in[i] = in[i].m_inv;
+            }
+            if(g.in0 == NO_GATE)
+                in[0] = in[1];
+            else if(g.in1 == NO_GATE)
+                in[1] = in[0];
+
+            signal result;
+            if(fold(g.type, in[0], in[1], result) && l.first != static_cast<size_t>(-1)){
+                signals[index] = result;
+                if(is_constant(result))
+                    report.constant_gates.push_back(m_gate_uids[index]);
+                else
+                    report.wire_gates.push_back(m_gate_uids[index]);
             }
+            else
+                signals[index] = signal{index, false};
         }
-    }while(current_input != vector<bool>(m_inputs.size(), 0));
+    }
+
+    //The constant and wire gates aren't read by anybody anymore, the others are dead if they don't reach the outputs
+    vector<size_t> removed_gates;
+    find_unreachable_gates(removed_gates);
+    for(const auto& uid : removed_gates){
+        if(signals[gate_index(uid)].m_index == gate_index(uid))
+            report.dead_gates.push_back(uid);
+    }
+
+    remove_gates(removed_gates);
+    regen_fanouts();
+    report.num_gates_after = report.num_gates_before - report.num_removed();
+
+    return 0;
+}
+
+//Function to find the gates with the same output as another gate, or its inverse, and connect their readers to that gate
+//instead, removing them together with the gates left without readers (FRAIG-style sweeping).
+//The circuit is first simulated with 64 * SWEEP_WORDS_PER_NET random input vectors, drawn from the seed: the nets with
+//the same output, or the inverse one, on all the vectors (their signature) are candidate equivalences. Every candidate
+//is compared with at most SWEEP_MAX_CHECKS_PER_NET nets of its class preceding it, and it's merged with the first one
+//proven equivalent, or becomes a candidate to compare the following nets with. The equivalences are proven by
+//comparing the BDDs of the nets, built over all the inputs while they fit in SWEEP_MAX_BDD_NODES nodes, and then by
+//simulating all the combinations of the inputs the two nets depend on, if they're at most SWEEP_MAX_EXHAUSTIVE_INPUTS,
+//or otherwise with the SAT solver, which gives up after SWEEP_SAT_MAX_CONFLICTS conflicts.
+//The output buffers are never merged, and the gates that were already not reaching the outputs are removed too.
+//Returns 1 if some gates have their inputs not connected
+int circuit::sweep_equivalent_gates(const uint64_t& seed, sweep_report& report){
+    if(compile())
+        return 1;
+
+    const flat_netlist& fn = m_compiled;
+    const size_t words_per_net = SWEEP_WORDS_PER_NET;
+    const size_t num_inputs = m_inputs.size();
+    const uint32_t first_op_net = num_inputs + 2;
+
+    report = sweep_report();
+    report.num_gates_before = num_gates();
+
+    //Signatures of the nets, complemented when their first bit is 1 so that inverse nets get the same signature
+    vector<uint64_t> nets(fn.m_num_nets * words_per_net, 0);
+    fill(nets.begin() + words_per_net, nets.begin() + 2 * words_per_net, ~uint64_t(0));
+    random_words generator(seed);
+    for(size_t w = 2 * words_per_net; w < first_op_net * words_per_net; ++w)
+        nets[w] = generator.next();
+
+    run_ops(nets.data(), words_per_net, 1);
+
+    vector<uint8_t> complemented(fn.m_num_nets);
+    for(uint32_t net = 0; net < fn.m_num_nets; ++net){
+        complemented[net] = nets[net * words_per_net] & 1;
+        if(complemented[net]){
+            for(size_t w = 0; w < words_per_net; ++w)
+                nets[net * words_per_net + w] = ~nets[net * words_per_net + w];
+        }
+    }
+
+    //Classes of nets with the same signature, in topological order. The nets are hashed by signature, and the classes
+    //whose signatures collide are told apart by comparing them with the first net of each
+    vector<uint8_t> is_output(fn.m_num_nets, false);
+    for(const auto& net : fn.m_output_nets)
+        is_output[net] = true;
+
+    vector<vector<uint32_t>> classes;
+    unordered_map<uint64_t, vector<size_t>> classes_of_hash;
+    for(uint32_t net = 0; net < fn.m_num_nets; ++net){
+        if(is_output[net])
+            continue;
+
+        const uint64_t* signature = &nets[net * words_per_net];
+        uint64_t hash = 0;
+        for(size_t w = 0; w < words_per_net; ++w)
+            hash = (hash ^ signature[w]) * 0x9E3779B97F4A7C15;
+
+        vector<size_t>& candidates = classes_of_hash[hash];
+        const auto it = find_if(candidates.begin(), candidates.end(), [&](const size_t& c){
+            return equal(signature, signature + words_per_net, &nets[classes[c][0] * words_per_net]);
+        });
+
+        if(it != candidates.end())
+            classes[*it].push_back(net);
+        else {
+            candidates.push_back(classes.size());
+            classes.push_back({net});
+        }
+    }
+
+    vector<uint8_t> is_candidate(fn.m_num_nets, false);
+    for(const auto& c : classes){
+        if(c.size() < 2)
+            continue;
+
+        ++report.num_candidate_classes;
+        for(const auto& net : c)
+            is_candidate[net] = true;
+    }
+
+    //BDDs of the candidates, complemented like their signatures, so that equivalent nets get the same BDD. The BDD of
+    //every other net is dereferenced after its last reader, and the nets from first_net_without_bdd on don't have one
+    bdd_manager manager(num_inputs, SWEEP_MAX_BDD_NODES);
+    vector<uint32_t> bdds(fn.m_num_nets);
+    vector<uint32_t> normalized_bdds(fn.m_num_nets);
+    vector<uint32_t> readers_left(fn.m_num_nets);
+    for(uint32_t net = 0; net < fn.m_num_nets; ++net)
+        readers_left[net] = fn.m_fanout_offsets[net + 1] - fn.m_fanout_offsets[net];
+
+    auto keep = [&](const uint32_t& net, const uint32_t& f){
+        bdds[net] = f;
+        if(readers_left[net] > 0)
+            manager.ref(f);
+
+        if(is_candidate[net]){
+            normalized_bdds[net] = (complemented[net] ? manager.bdd_not(f) : f);
+            manager.ref(normalized_bdds[net]);
+        }
+    };
+    auto release = [&](const uint32_t& net){
+        if(--readers_left[net] == 0)
+            manager.deref(bdds[net]);
+    };
+
+    keep(0, BDD_FALSE);
+    keep(1, BDD_TRUE);
+    for(uint32_t net = 2; net < first_op_net; ++net)
+        keep(net, manager.var(net - 2));
+
+    uint32_t first_net_without_bdd = fn.m_num_nets;
+    size_t garbage_collection_nodes = SWEEP_MAX_BDD_NODES / 2;
+    for(const auto& op : fn.m_ops){
+        keep(op.net_out, apply_bdd_op(manager, op, bdds[op.net_in0], bdds[op.net_in1]));
+        if(manager.overflowed()){
+            first_net_without_bdd = op.net_out;
+            break;
+        }
+
+        if(op.net_in0 > 1)
+            release(op.net_in0);
+        if(op.net_in1 > 1 && op.net_in1 != op.net_in0)
+            release(op.net_in1);
+
+        if(manager.num_nodes() > garbage_collection_nodes){
+            manager.collect_garbage();
+            garbage_collection_nodes = max(garbage_collection_nodes, 2 * manager.num_nodes());
+        }
+    }
+
+    //Inputs each net depends on, one bit per input, only needed if some nets don't have a BDD
+    const size_t support_words = (num_inputs + 63) / 64;
+    vector<uint64_t> supports;
+    if(first_net_without_bdd < fn.m_num_nets){
+        supports.assign(fn.m_num_nets * support_words, 0);
+        for(size_t i = 0; i < num_inputs; ++i)
+            supports[(i + 2) * support_words + i / 64] |= uint64_t(1) << (i % 64);
+
+        for(const auto& op : fn.m_ops){
+            for(size_t w = 0; w < support_words; ++w)
+                supports[op.net_out * support_words + w] = supports[op.net_in0 * support_words + w] | supports[op.net_in1 * support_words + w];
+        }
+    }
+
+    //Function to list, in topological order, the ops in the fanin cones of two nets
+    vector<uint8_t> in_cone(fn.m_num_nets, false);
+    auto find_cone = [&](const uint32_t& a, const uint32_t& b, vector<uint32_t>& cone_ops){
+        cone_ops.clear();
+        vector<uint32_t> to_visit = {a, b};
+        while(!to_visit.empty()){
+            const uint32_t net = to_visit.back();
+            to_visit.pop_back();
+            if(net < first_op_net || in_cone[net])
+                continue;
+
+            in_cone[net] = true;
+            cone_ops.push_back(net - first_op_net);
+            to_visit.push_back(fn.m_ops[net - first_op_net].net_in0);
+            to_visit.push_back(fn.m_ops[net - first_op_net].net_in1);
+        }
+
+        sort(cone_ops.begin(), cone_ops.end());
+        for(const auto& o : cone_ops)
+            in_cone[fn.m_ops[o].net_out] = false;
+    };
+
+    //Function to check if two nets are equivalent (or inverse) by simulating the ops in their fanin cones over all the
+    //combinations of the inputs they depend on, 64 * SWEEP_WORDS_PER_NET at a time.
+    //Returns 0 if they're equivalent, 1 if they aren't, 2 if they depend on too many inputs
+    vector<uint32_t> cone_ops;
+    auto check_exhaustively = [&](const uint32_t& a, const uint32_t& b, const bool& inverse){
+        vector<size_t> support;
+        for(size_t i = 0; i < num_inputs; ++i){
+            const size_t w = i / 64;
+            if(((supports[a * support_words + w] | supports[b * support_words + w]) >> (i % 64)) & 1)
+                support.push_back(i);
+        }
+        if(support.size() > SWEEP_MAX_EXHAUSTIVE_INPUTS)
+            return 2;
+
+        find_cone(a, b, cone_ops);
+
+        //The first 6 inputs take the same patterns in every word, the others are constant in each word. The inputs outside
+        //the support aren't read by the cone, so they don't need to be set
+        static const uint64_t input_patterns[6] = {0xAAAAAAAAAAAAAAAA, 0xCCCCCCCCCCCCCCCC, 0xF0F0F0F0F0F0F0F0,
+                                                   0xFF00FF00FF00FF00, 0xFFFF0000FFFF0000, 0xFFFFFFFF00000000};
+        fill(nets.begin(), nets.begin() + words_per_net, 0);
+        fill(nets.begin() + words_per_net, nets.begin() + 2 * words_per_net, ~uint64_t(0));
+
+        const uint64_t num_combinations = uint64_t(1) << support.size();
+        for(uint64_t first_word = 0; 64 * first_word < num_combinations || first_word == 0; first_word += words_per_net){
+            for(size_t j = 0; j < support.size(); ++j){
+                uint64_t* input_net = &nets[(support[j] + 2) * words_per_net];
+                for(size_t w = 0; w < words_per_net; ++w)
+                    input_net[w] = (j < 6 ? input_patterns[j] : (((first_word + w) >> (j - 6)) & 1 ? ~uint64_t(0) : 0));
+            }
+
+            for(const auto& o : cone_ops){
+                const gate_op& op = fn.m_ops[o];
+                for(size_t w = 0; w < words_per_net; ++w)
+                    nets[op.net_out * words_per_net + w] = op.eval(nets[op.net_in0 * words_per_net + w], nets[op.net_in1 * words_per_net + w]);
+            }
+
+            const uint64_t difference = (inverse ? ~uint64_t(0) : 0);
+            for(size_t w = 0; w < words_per_net; ++w){
+                if((nets[a * words_per_net + w] ^ nets[b * words_per_net + w]) != difference)
+                    return 1;
+            }
+        }
+
+        return 0;
+    };
+
+    //Function to check if two nets are equivalent (or inverse) with the SAT solver, looking for an assignment of the inputs
+    //for which they differ. The solver is reused for the next checks, until it has more than SWEEP_SAT_MAX_VARS
+    //variables: the clauses of every op, constraining the variable of its output to the function of the variables of its
+    //inputs, are added the first time the op is in the fanin cone of a net checked, reading the nets already merged from
+    //their equivalent ones, and the clauses of every equivalence proven are added too, which helps the next checks.
+    //The two nets are compared through a new variable, assumed to be true, which implies that they differ.
+    //Returns 0 if they're equivalent, 1 if they aren't, 2 if the solver gives up after SWEEP_SAT_MAX_CONFLICTS conflicts
+    sat_solver solver;
+    vector<uint32_t> var_of_net;
+    vector<uint32_t> merged_net(fn.m_num_nets, UINT32_MAX);
+    vector<uint8_t> merged_inverse(fn.m_num_nets, false);
+    auto resolve = [&](const uint32_t& net){return merged_net[net] == UINT32_MAX ? net : merged_net[net];};
+    auto lit_of_net = [&](const uint32_t& net){
+        return merged_net[net] == UINT32_MAX ? 2 * var_of_net[net] : 2 * var_of_net[merged_net[net]] + merged_inverse[net];
+    };
+
+    auto encode_cones = [&](const uint32_t& a, const uint32_t& b){
+        if(solver.num_vars() > SWEEP_SAT_MAX_VARS){
+            solver = sat_solver();
+            var_of_net.clear();
+        }
+
+        if(var_of_net.empty()){
+            var_of_net.assign(fn.m_num_nets, UINT32_MAX);
+            for(uint32_t net = 0; net < first_op_net; ++net)
+                var_of_net[net] = solver.new_var();
+            solver.add_clause({2 * var_of_net[0] + 1});
+            solver.add_clause({2 * var_of_net[1]});
+        }
+
+        vector<uint32_t> new_ops;
+        vector<uint32_t> to_visit = {a, b};
+        while(!to_visit.empty()){
+            const uint32_t net = to_visit.back();
+            to_visit.pop_back();
+            if(var_of_net[net] != UINT32_MAX)
+                continue;
+
+            const gate_op& op = fn.m_ops[net - first_op_net];
+            var_of_net[net] = solver.new_var();
+            new_ops.push_back(net - first_op_net);
+            to_visit.push_back(resolve(op.net_in0));
+            to_visit.push_back(resolve(op.net_in1));
+        }
+
+        for(const auto& o : new_ops){
+            const gate_op& op = fn.m_ops[o];
+            const uint32_t x = lit_of_net(op.net_in0) ^ op.inv_in0;
+            const uint32_t y = lit_of_net(op.net_in1) ^ op.inv_in1;
+            const bool inverting = (op.type == gate_type::not_gate || op.type == gate_type::nand_gate ||
+                                    op.type == gate_type::nor_gate || op.type == gate_type::nxor_gate);
+            const uint32_t z = 2 * var_of_net[op.net_out] + inverting;
+
+            switch(op.type){
+                case gate_type::buffer:
+                case gate_type::not_gate:
+                    solver.add_clause({z ^ 1, x});
+                    solver.add_clause({z, x ^ 1});
+                    break;
+                case gate_type::and_gate:
+                case gate_type::nand_gate:
+                    solver.add_clause({z ^ 1, x});
+                    solver.add_clause({z ^ 1, y});
+                    solver.add_clause({z, x ^ 1, y ^ 1});
+                    break;
+                case gate_type::or_gate:
+                case gate_type::nor_gate:
+                    solver.add_clause({z, x ^ 1});
+                    solver.add_clause({z, y ^ 1});
+                    solver.add_clause({z ^ 1, x, y});
+                    break;
+                default:
+                    solver.add_clause({z ^ 1, x, y});
+                    solver.add_clause({z ^ 1, x ^ 1, y ^ 1});
+                    solver.add_clause({z, x ^ 1, y});
+                    solver.add_clause({z, x, y ^ 1});
+                    break;
+            }
+        }
+    };
+
+    //The assignments of the inputs found by the solver are kept, up to 64 * SWEEP_WORDS_PER_NET of them, and simulated
+    //with the circuit: the nets which differ on any of them can't be equivalent, so they don't need to be checked again
+    vector<uint64_t> counterexample_nets;
+    size_t num_counterexamples = 0;
+    auto add_counterexample = [&](){
+        if(counterexample_nets.empty()){
+            counterexample_nets.assign(fn.m_num_nets * words_per_net, 0);
+            fill(counterexample_nets.begin() + words_per_net, counterexample_nets.begin() + 2 * words_per_net, ~uint64_t(0));
+        }
+
+        const size_t lane = num_counterexamples++ % (64 * words_per_net);
+        for(size_t i = 0; i < num_inputs; ++i){
+            uint64_t& word = counterexample_nets[(i + 2) * words_per_net + lane / 64];
+            word = (word & ~(uint64_t(1) << (lane % 64))) | (uint64_t(solver.model_value(var_of_net[i + 2])) << (lane % 64));
+        }
+
+        run_ops(counterexample_nets.data(), words_per_net, 1);
+    };
+    auto differ_on_counterexamples = [&](const uint32_t& a, const uint32_t& b, const bool& inverse){
+        const uint64_t difference = (inverse ? ~uint64_t(0) : 0);
+        for(size_t w = 0; w < words_per_net && 64 * w < num_counterexamples; ++w){
+            uint64_t valid_lanes;
+            set_valid_lanes(64 * w, num_counterexamples, 1, &valid_lanes);
+            if((counterexample_nets[a * words_per_net + w] ^ counterexample_nets[b * words_per_net + w] ^ difference) & valid_lanes)
+                return true;
+        }
+
+        return false;
+    };
+
+    auto check_with_sat = [&](const uint32_t& a, const uint32_t& b, const bool& inverse){
+        encode_cones(a, b);
+
+        const uint32_t lit_a = 2 * var_of_net[a];
+        const uint32_t lit_b = 2 * var_of_net[b] + inverse;
+        const uint32_t differ = 2 * solver.new_var();
+        solver.add_clause({differ ^ 1, lit_a, lit_b});
+        solver.add_clause({differ ^ 1, lit_a ^ 1, lit_b ^ 1});
+
+        const sat_result result = solver.solve({differ}, SWEEP_SAT_MAX_CONFLICTS);
+        if(result == sat_result::satisfiable)
+            add_counterexample();
+
+        //The comparison isn't needed anymore, so its variable is set to false, satisfying its clauses
+        solver.add_clause({differ ^ 1});
+
+        switch(result){
+            case sat_result::unsatisfiable:
+                solver.add_clause({lit_a ^ 1, lit_b});
+                solver.add_clause({lit_a, lit_b ^ 1});
+                return 0;
+            case sat_result::satisfiable:
+                return 1;
+            default:
+                return 2;
+        }
+    };
+
+    //Every candidate, in topological order, is compared with the candidates of its class which haven't been merged. The
+    //nets each candidate is merged with are kept by uid, with whether the inverse of that net is taken
+    vector<size_t> class_of_net(fn.m_num_nets, SIZE_MAX);
+    for(size_t c = 0; c < classes.size(); ++c){
+        if(classes[c].size() > 1){
+            for(const auto& net : classes[c])
+                class_of_net[net] = c;
+        }
+    }
+
+    vector<vector<uint32_t>> representatives(classes.size());
+    vector<uint32_t> merged_into(m_gates.size(), NO_GATE);
+    vector<uint8_t> merged_inverted(m_gates.size(), false);
+    for(uint32_t net = 0; net < fn.m_num_nets; ++net){
+        if(class_of_net[net] == SIZE_MAX)
+            continue;
+
+        vector<uint32_t>& class_representatives = representatives[class_of_net[net]];
+        bool merged = false;
+
+        for(size_t r = 0; r < class_representatives.size() && r < SWEEP_MAX_CHECKS_PER_NET && net >= first_op_net; ++r){
+            const uint32_t representative = class_representatives[r];
+            const bool inverse = (complemented[net] != complemented[representative]);
+
+            int result;
+            if(net < first_net_without_bdd)
+                result = (normalized_bdds[net] == normalized_bdds[representative] ? 0 : 1);
+            else if(differ_on_counterexamples(representative, net, inverse))
+                result = 1;
+            else {
+                result = check_exhaustively(representative, net, inverse);
+                if(result == 2)
+                    result = check_with_sat(representative, net, inverse);
+            }
+
+            if(result == 0){
+                //The constants are always taken as the non inverted outputs of the gates 0 and 1
+                size_t uid_equivalent = fn.m_net_uids[representative];
+                bool inverted = inverse;
+                if(representative <= 1){
+                    uid_equivalent = fn.m_net_uids[representative ^ inverse];
+                    inverted = false;
+                }
+
+                merged_net[net] = representative;
+                merged_inverse[net] = inverse;
+                merged_into[gate_index(fn.m_net_uids[net])] = gate_index(uid_equivalent);
+                merged_inverted[gate_index(fn.m_net_uids[net])] = inverted;
+                report.merged_gates.push_back(equivalent_gate{fn.m_net_uids[net], uid_equivalent, inverted});
+                ++report.num_proven;
+                merged = true;
+                break;
+            }
+            else if(result == 1)
+                ++report.num_refuted;
+            else
+                ++report.num_unresolved;
+        }
+
+        if(!merged)
+            class_representatives.push_back(net);
+    }
+
+    //Connect the readers of the merged gates to their equivalent ones, which precede them, and remove the gates left
+    //without readers
+    for(auto& l : m_layers){
+        for(const auto& index : l.second.m_indices){
+            gate& g = m_gates[index];
+            uint32_t* gate_in[2] = {&g.in0, &g.in1};
+            bool* inv_in[2] = {&g.inv_in0, &g.inv_in1};
+
+            for(size_t i = 0; i < 2; ++i){
+                if(*gate_in[i] != NO_GATE && merged_into[*gate_in[i]] != NO_GATE){
+                    *inv_in[i] ^= merged_inverted[*gate_in[i]];
+                    *gate_in[i] = merged_into[*gate_in[i]];
+                }
+            }
+        }
+    }
+
+    vector<size_t> removed_gates;
+    find_unreachable_gates(removed_gates);
+    for(const auto& uid : removed_gates){
+        if(merged_into[gate_index(uid)] == NO_GATE)
+            report.dead_gates.push_back(uid);
+    }
+
+    remove_gates(removed_gates);
+    regen_fanouts();
+    report.num_gates_after = num_gates();
+
+    return 0;
+}
+
+//Function to convert the circuit to an and-inverter graph, with the same inputs and outputs.
+//Every gate becomes at most three AND nodes (XOR and NXOR gates), and the inversions become inverted literals.
+//Returns 1 if some gates have their inputs not connected
+int circuit::to_aig(aig& graph){
+    if(compile())
+        return 1;
+
+    const flat_netlist& fn = m_compiled;
+    graph = aig(m_inputs.size());
+
+    vector<uint32_t> lits(fn.m_num_nets);
+    lits[0] = AIG_FALSE;
+    lits[1] = AIG_TRUE;
+    for(size_t i = 0; i < m_inputs.size(); ++i)
+        lits[i + 2] = graph.input(i);
+
+    for(const auto& op : fn.m_ops){
+        const uint32_t a = lits[op.net_in0] ^ op.inv_in0;
+        const uint32_t b = lits[op.net_in1] ^ op.inv_in1;
+        uint32_t result;
+
+        switch(op.type){
+            case gate_type::buffer:
+                result = a;
+                break;
+            case gate_type::not_gate:
+                result = aig::lit_not(a);
+                break;
+            case gate_type::and_gate:
+                result = graph.make_and(a, b);
+                break;
+            case gate_type::nand_gate:
+                result = aig::lit_not(graph.make_and(a, b));
+                break;
+            case gate_type::or_gate:
+                result = graph.make_or(a, b);
+                break;
+            case gate_type::nor_gate:
+                result = aig::lit_not(graph.make_or(a, b));
+                break;
+            case gate_type::xor_gate:
+                result = graph.make_xor(a, b);
+                break;
+            default:
+                result = aig::lit_not(graph.make_xor(a, b));
+                break;
+        }
+
+        lits[op.net_out] = result;
+    }
+
+    for(const auto& net : fn.m_output_nets)
+        graph.add_output(lits[net]);
+
+    graph.cleanup();
+
+    return 0;
+}
+
+//Function to replace all the gates of the circuit, except for the inputs and the output buffers, with the AND gates of
+//an and-inverter graph with the same number of inputs and outputs. Every AND node is placed in the layer equal to its
+//level, so the circuit has as many layers as the depth of the graph. The outputs driven by a constant are connected
+//to the gates 0 and 1.
+//Returns 1 if the graph doesn't have the same number of inputs and outputs as the circuit
+int circuit::from_aig(const aig& graph){
+    if(graph.num_inputs() != m_inputs.size() || graph.outputs().size() != m_outputs.size())
+        return 1;
+
+    vector<size_t> removed_gates;
+    for(const auto& l : m_layers){
+        if(l.first == 0 || l.first == static_cast<size_t>(-1))
+            continue;
+
+        for(const auto& i : l.second.m_indices)
+            removed_gates.push_back(m_gate_uids[i]);
+    }
+    remove_gates(removed_gates);
+
+    //The uid of every node, starting after the highest uid left in the circuit
+    const vector<uint32_t>& input_layer = m_layers[0].m_indices;
+    const vector<uint32_t>& output_layer = m_layers[static_cast<size_t>(-1)].m_indices;
+    m_next_gate_uid = max(m_gate_uids[input_layer.back()], m_gate_uids[output_layer.back()]) + 1;
+
+    //The input layer holds the constants 0 and 1, followed by the inputs
+    vector<uint32_t> node_indices(graph.num_nodes());
+    node_indices[0] = input_layer[0];
+    const uint32_t const1_index = input_layer[1];
+    for(uint32_t node = 1; node <= graph.num_inputs(); ++node)
+        node_indices[node] = input_layer[node + 1];
+
+    vector<uint32_t> node_levels;
+    graph.levels(node_levels);
+    m_gates.reserve(m_gate_indices.size() + graph.num_ands());
+    for(uint32_t node = graph.num_inputs() + 1; node < graph.num_nodes(); ++node){
+        add_layer(node_levels[node]);
+        node_indices[node] = create_gate(m_next_gate_uid++, gate_type::and_gate, node_levels[node]);
+
+        gate& g = m_gates[node_indices[node]];
+        g.in0 = node_indices[aig::lit_node(graph.fanin0(node))];
+        g.inv_in0 = aig::lit_inv(graph.fanin0(node));
+        g.in1 = node_indices[aig::lit_node(graph.fanin1(node))];
+        g.inv_in1 = aig::lit_inv(graph.fanin1(node));
+    }
+
+    for(size_t o = 0; o < graph.outputs().size(); ++o){
+        const uint32_t lit = graph.outputs()[o];
+        gate& g = m_gates[output_layer[o]];
+        if(lit == AIG_TRUE){
+            g.in0 = const1_index;
+            g.inv_in0 = false;
+        }
+        else {
+            g.in0 = node_indices[aig::lit_node(lit)];
+            g.inv_in0 = aig::lit_inv(lit);
+        }
+        g.in1 = NO_GATE;
+        g.inv_in1 = false;
+    }
+
+    regen_fanouts();
 
-    set_inputs(inputs_to_restore);
     return 0;
 }
 
@@ -523,26 +2898,27 @@ void circuit::print_circuit(const bool& print_gates, const bool& print_connectio
         else
             os << "Layer " << l.first << ":" << endl;
         
-        for(const auto& p : l.second.m_gates){
-            os << "    " << gate_type_to_str(p.second.type) << " (" << p.second.uid_gate << ")" << (l.first != 0 && print_connections ? ":" : "") << endl;
+        for(const auto& i : l.second.m_indices){
+            const gate& g = m_gates[i];
+            os << "    " << gate_type_to_str(g.type) << " (" << m_gate_uids[i] << ")" << (l.first != 0 && print_connections ? ":" : "") << endl;
 
             if(l.first != 0 && print_connections){
-                if(p.second.type == gate_type::buffer || p.second.type == gate_type::not_gate){
-                    const int unconnected_inputs = (p.second.ptr_gate_in0 == nullptr) + (p.second.ptr_gate_in1 == nullptr);
+                if(g.type == gate_type::buffer || g.type == gate_type::not_gate){
+                    const int unconnected_inputs = (g.in0 == NO_GATE) + (g.in1 == NO_GATE);
                     if(unconnected_inputs == 2){
                         os << "        " << "in_0: nc" << endl;
                         os << "        " << "in_1: nc" << endl;
                     }
                     else {
-                        if(p.second.ptr_gate_in0 != nullptr)
-                            os << "        " << "in_0: " << (p.second.take_inv_output_in_in0 ? "!" : "") + to_string(p.second.ptr_gate_in0->uid_gate) << endl;
-                        if(p.second.ptr_gate_in1 != nullptr)
-                            os << "        " << "in_1: " << (p.second.take_inv_output_in_in1 ? "!" : "") + to_string(p.second.ptr_gate_in1->uid_gate) << endl;
+                        if(g.in0 != NO_GATE)
+                            os << "        " << "in_0: " << (g.inv_in0 ? "!" : "") + to_string(m_gate_uids[g.in0]) << endl;
+                        if(g.in1 != NO_GATE)
+                            os << "        " << "in_1: " << (g.inv_in1 ? "!" : "") + to_string(m_gate_uids[g.in1]) << endl;
                     }
                 }
                 else {
-                    os << "        " << "in_0: " << (p.second.ptr_gate_in0 == nullptr ? "nc" : (p.second.take_inv_output_in_in0 ? "!" : "") + to_string(p.second.ptr_gate_in0->uid_gate)) << endl;
-                    os << "        " << "in_1: " << (p.second.ptr_gate_in1 == nullptr ? "nc" : (p.second.take_inv_output_in_in1 ? "!" : "") + to_string(p.second.ptr_gate_in1->uid_gate)) << endl;
+                    os << "        " << "in_0: " << (g.in0 == NO_GATE ? "nc" : (g.inv_in0 ? "!" : "") + to_string(m_gate_uids[g.in0])) << endl;
+                    os << "        " << "in_1: " << (g.in1 == NO_GATE ? "nc" : (g.inv_in1 ? "!" : "") + to_string(m_gate_uids[g.in1])) << endl;
                 }
             }
         }
@@ -564,20 +2940,21 @@ void circuit::list_unconnected(ostream& os){
 
         bool unconnected_gates = false;
 
-        for(const auto& p : l.second.m_gates){
-            if(p.second.type == gate_type::buffer || p.second.type == gate_type::not_gate){
-                if(p.second.ptr_gate_in0 == nullptr && p.second.ptr_gate_in1 == nullptr){
-                    os << "    " << gate_type_to_str(p.second.type) << " (" << p.second.uid_gate << ")" << endl;
+        for(const auto& i : l.second.m_indices){
+            const gate& g = m_gates[i];
+            if(g.type == gate_type::buffer || g.type == gate_type::not_gate){
+                if(g.in0 == NO_GATE && g.in1 == NO_GATE){
+                    os << "    " << gate_type_to_str(g.type) << " (" << m_gate_uids[i] << ")" << endl;
                     unconnected_gates = true;
                 }
             }
             else {
-                if(p.second.ptr_gate_in0 == nullptr){
-                    os << "    " << gate_type_to_str(p.second.type) << " (" << p.second.uid_gate << ") - input 0" << endl;
+                if(g.in0 == NO_GATE){
+                    os << "    " << gate_type_to_str(g.type) << " (" << m_gate_uids[i] << ") - input 0" << endl;
                     unconnected_gates = true;
                 }
-                if(p.second.ptr_gate_in1 == nullptr){
-                    os << "    " << gate_type_to_str(p.second.type) << " (" << p.second.uid_gate << ") - input 1" << endl;
+                if(g.in1 == NO_GATE){
+                    os << "    " << gate_type_to_str(g.type) << " (" << m_gate_uids[i] << ") - input 1" << endl;
                     unconnected_gates = true;
                 }
             }
@@ -610,8 +2987,8 @@ int circuit::save_circuit_to_file(const std::string& filename){
     //Write gates in layers to file
     for(const auto& l : m_layers){
         if(l.first != 0 && l.first != static_cast<size_t>(-1)){
-            for(const auto& g : l.second.m_gates){
-                out_file << "G " << g.second.uid_gate << " " << gate_type_to_str(g.second.type) << " " << l.first << "\n";
+            for(const auto& i : l.second.m_indices){
+                out_file << "G " << m_gate_uids[i] << " " << gate_type_to_str(m_gates[i].type) << " " << l.first << "\n";
             }
         }
     }
@@ -619,11 +2996,12 @@ int circuit::save_circuit_to_file(const std::string& filename){
     //Write connections between gates to file
     for(const auto& l : m_layers){
         if(l.first != 0){
-            for(const auto& g : l.second.m_gates){
-                if(g.second.ptr_gate_in0 != nullptr)
-                    out_file << "C " << g.second.ptr_gate_in0->uid_gate << " " << g.second.take_inv_output_in_in0 << " " << g.second.uid_gate << " 0\n";
-                if(g.second.ptr_gate_in1 != nullptr)
-                    out_file << "C " << g.second.ptr_gate_in1->uid_gate << " " << g.second.take_inv_output_in_in1 << " " << g.second.uid_gate << " 1\n";
+            for(const auto& i : l.second.m_indices){
+                const gate& g = m_gates[i];
+                if(g.in0 != NO_GATE)
+                    out_file << "C " << m_gate_uids[g.in0] << " " << g.inv_in0 << " " << m_gate_uids[i] << " 0\n";
+                if(g.in1 != NO_GATE)
+                    out_file << "C " << m_gate_uids[g.in1] << " " << g.inv_in1 << " " << m_gate_uids[i] << " 1\n";
             }
         }
     }
@@ -634,150 +3012,596 @@ int circuit::save_circuit_to_file(const std::string& filename){
 }
 
 int circuit::load_circuit_from_file(const std::string& filename){
-    ifstream in_file(filename);
+    size_t error_line, error_column;
+    return load_circuit_from_file(filename, error_line, error_column);
+}
 
-    if(!in_file.is_open())
+//Function to load a circuit saved by save_circuit_to_file, replacing the current one only if the whole file is valid.
+//The file is mapped in memory and parsed in a single pass, building the gates and their connections directly, after
+//counting the gate lines to allocate their storage at once.
+//Returns 1 if the file can't be opened, 2 (3) if the number of inputs (outputs) is missing and 20 (30) if it's badly
+//formatted, 4 if a line is badly formatted, 40 if the lines aren't in the order L, G and C, and 5 if a line refers to
+//a layer or gate that doesn't exist (or already exists), or connects a gate to one that isn't in a following layer.
+//In all the cases after 1, the line and column of the error are written in error_line and error_column
+int circuit::load_circuit_from_file(const std::string& filename, size_t& error_line, size_t& error_column){
+    mapped_file file;
+    if(file.open(filename))
         return 1;
 
-    string line;
-    circuit loaded_circuit(4, 4);
-    const regex num_inputs_re(R"foo(^I \d+$)foo");
-    const regex num_outputs_re(R"foo(^O \d+$)foo");
-    const regex layer_re(R"foo(^L \d+$)foo");
-    const regex gate_re(R"foo(^G \d+ (?:BUF|NOT|AND| OR|XOR|NND|NOR|NXR) \d+$)foo");
-    const regex connection_re(R"foo(^C \d+ \d+ \d+ \d+$)foo");
+    netlist_scanner scanner(file.data(), file.data() + file.size());
+    auto fail = [&](const int& code){
+        error_line = scanner.line();
+        error_column = scanner.column();
+        return code;
+    };
+
+    //Read number of inputs and outputs
+    size_t num_inputs_tmp, num_outputs_tmp;
+    if(scanner.at_end())
+        return fail(2);
+    if(scanner.line_type() != 'I' || !scanner.number(num_inputs_tmp) || !scanner.end_of_line())
+        return fail(20);
+    if(scanner.at_end())
+        return fail(3);
+    if(scanner.line_type() != 'O' || !scanner.number(num_outputs_tmp) || !scanner.end_of_line())
+        return fail(30);
+
+    circuit loaded_circuit(num_inputs_tmp, num_outputs_tmp);
+
+    const char* text_end = file.data() + file.size();
+    size_t num_gate_lines = 0;
+    for(const char* p = file.data(); p < text_end; ++p){
+        num_gate_lines += (*p == 'G');
+        p = static_cast<const char*>(memchr(p, '\n', text_end - p));
+        if(p == nullptr)
+            break;
+    }
+    loaded_circuit.m_gates.reserve(loaded_circuit.m_gates.size() + num_gate_lines);
+    loaded_circuit.m_gate_uids.reserve(loaded_circuit.m_gates.capacity());
+    loaded_circuit.m_gate_layers.reserve(loaded_circuit.m_gates.capacity());
+    loaded_circuit.m_fanouts.reserve(loaded_circuit.m_gates.capacity());
+    loaded_circuit.m_gate_indices.reserve(loaded_circuit.m_gates.capacity());
+
+    //Read rest of the data from the file, the sections being in the order of line_types
+    const string line_types = "LGC";
+    size_t section = 0;
+    size_t highest_gate_uid = num_inputs_tmp + 2 + num_outputs_tmp - 1;
+    while(!scanner.at_end()){
+        const char type = scanner.line_type();
+        const size_t line_section = line_types.find(type);
+        if(type == 0 || line_section == string::npos)
+            return fail(4);
+        if(line_section < section)
+            return fail(40);
+        section = line_section;
+
+        if(type == 'L'){
+            size_t num_layer;
+            if(!scanner.number(num_layer))
+                return fail(4);
+            if(loaded_circuit.m_layers.contains(num_layer))
+                return fail(5);
+
+            loaded_circuit.add_layer(num_layer);
+        }
+        else if(type == 'G'){
+            size_t uid;
+            gate_type gt;
+            size_t num_layer;
+            if(!scanner.number(uid))
+                return fail(4);
+            if(loaded_circuit.m_gate_indices.contains(uid))
+                return fail(5);
+            if(!scanner.type(gt) || !scanner.number(num_layer))
+                return fail(4);
+            if(loaded_circuit.add_gate_with_uid(uid, gate(gt), num_layer))
+                return fail(5);
+
+            highest_gate_uid = max(highest_gate_uid, uid);
+        }
+        else {
+            size_t uid_out, uid_in;
+            bool take_inv_output, num_input;
+            if(!scanner.number(uid_out))
+                return fail(4);
+            const auto it_out = loaded_circuit.m_gate_indices.find(uid_out);
+            if(it_out == loaded_circuit.m_gate_indices.end())
+                return fail(5);
+            if(!scanner.bit(take_inv_output) || !scanner.number(uid_in))
+                return fail(4);
+            const auto it_in = loaded_circuit.m_gate_indices.find(uid_in);
+            if(it_in == loaded_circuit.m_gate_indices.end() || !(loaded_circuit.m_gate_layers[it_out->second] < loaded_circuit.m_gate_layers[it_in->second]))
+                return fail(5);
+            if(!scanner.bit(num_input))
+                return fail(4);
+
+            loaded_circuit.connect_input(it_in->second, num_input, it_out->second, take_inv_output);
+        }
+
+        if(!scanner.end_of_line())
+            return fail(4);
+    }
+
+    loaded_circuit.m_next_gate_uid = highest_gate_uid + 1;
+    loaded_circuit.m_kernel = m_kernel;
+    loaded_circuit.m_event_driven = m_event_driven;
+    *this = move(loaded_circuit);
 
-    //Read number of inputs and outputs from file
-    if(!getline(in_file, line))
+    return 0;
+}
+
+//Function to save the circuit in the binary format (see circuit_file.hpp). The gates are renumbered in the order of the
+//layers, so that the file has no holes left by the deleted gates.
+//Returns 1 if the file can't be opened or written
+int circuit::save_circuit_to_binary_file(const std::string& filename){
+    static_assert(sizeof(gate) == 12 && offsetof(gate, in0) == 0 && offsetof(gate, in1) == 4 && offsetof(gate, type) == 8 &&
+                  offsetof(gate, inv_in0) == 9 && offsetof(gate, inv_in1) == 10, "unexpected layout of struct gate");
+
+    const size_t num_gates_tmp = m_gate_indices.size();
+    const size_t num_layers = m_layers.size();
+    auto padded = [](const size_t& size){return (size + 7) & ~size_t(7);};
+    const size_t gates_size = padded(num_gates_tmp * sizeof(gate));
+
+    vector<uint32_t> new_index(m_gates.size());
+    uint32_t next_index = 0;
+    for(const auto& l : m_layers){
+        for(const auto& i : l.second.m_indices)
+            new_index[i] = next_index++;
+    }
+
+    //The records are written field by field in a zeroed buffer, so that their padding is always 0
+    vector<char> payload(gates_size + (num_gates_tmp + 2 * num_layers + 1) * sizeof(uint64_t), 0);
+    char* gate_records = payload.data();
+    uint64_t* uids = reinterpret_cast<uint64_t*>(payload.data() + gates_size);
+    uint64_t* layer_numbers = uids + num_gates_tmp;
+    uint64_t* layer_offsets = layer_numbers + num_layers;
+
+    size_t num_layer = 0;
+    next_index = 0;
+    for(const auto& l : m_layers){
+        layer_numbers[num_layer] = l.first;
+        layer_offsets[num_layer++] = next_index;
+        next_index += l.second.m_indices.size();
+
+        for(const auto& i : l.second.m_indices){
+            const gate& g = m_gates[i];
+            const uint32_t in[2] = {g.in0 == NO_GATE ? NO_GATE : new_index[g.in0], g.in1 == NO_GATE ? NO_GATE : new_index[g.in1]};
+            char* record = gate_records + new_index[i] * sizeof(gate);
+            memcpy(record + offsetof(gate, in0), &in[0], sizeof(uint32_t));
+            memcpy(record + offsetof(gate, in1), &in[1], sizeof(uint32_t));
+            memcpy(record + offsetof(gate, type), &g.type, sizeof(gate_type));
+            record[offsetof(gate, inv_in0)] = g.inv_in0;
+            record[offsetof(gate, inv_in1)] = g.inv_in1;
+            uids[new_index[i]] = m_gate_uids[i];
+        }
+    }
+    layer_offsets[num_layers] = num_gates_tmp;
+
+    binary_circuit_header header{};
+    copy_n(BINARY_CIRCUIT_MAGIC, sizeof(header.magic), header.magic);
+    header.version = BINARY_CIRCUIT_VERSION;
+    header.gate_size = sizeof(gate);
+    header.num_inputs = m_inputs.size();
+    header.num_outputs = m_outputs.size();
+    header.num_gates = num_gates_tmp;
+    header.num_layers = num_layers;
+    header.next_gate_uid = m_next_gate_uid;
+    header.checksum = binary_circuit_checksum(payload.data(), payload.size());
+
+    ofstream out_file(filename, ios::binary);
+    if(!out_file.is_open())
+        return 1;
+
+    out_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out_file.write(payload.data(), payload.size());
+
+    return out_file ? 0 : 1;
+}
+
+//Function to load a circuit saved in the binary format, replacing the current one only if the file is valid. The file
+//is mapped in memory and checked, then the records of the gates are copied at once.
+//Returns 1 if the file can't be opened, 2 if it isn't a circuit in the binary format, 3 if it has been written by an
+//unsupported version of the format or by a machine with a different layout of the gates, 4 if it's truncated or its
+//checksum doesn't match and 5 if its contents are inconsistent (e.g. a gate connected to one in a following layer)
+int circuit::load_circuit_from_binary_file(const std::string& filename){
+    mapped_file file;
+    if(file.open(filename))
+        return 1;
+
+    if(file.size() < sizeof(binary_circuit_header))
+        return 2;
+
+    binary_circuit_header header;
+    memcpy(&header, file.data(), sizeof(header));
+    if(memcmp(header.magic, BINARY_CIRCUIT_MAGIC, sizeof(header.magic)) != 0)
         return 2;
-    if(!regex_match(line, num_inputs_re))
-        return 20;
-    const size_t num_inputs_tmp = stoull(line.substr(2));
-    if(!getline(in_file, line))
+
+    if(header.version != BINARY_CIRCUIT_VERSION || header.gate_size != sizeof(gate))
         return 3;
-    if(!regex_match(line, num_outputs_re))
-        return 30;
-    const size_t num_outputs_tmp = stoull(line.substr(2));
-    loaded_circuit.set_io(num_inputs_tmp, num_outputs_tmp);
-
-    //Read rest of the data from the file
-    bool reading_layers = true;
-    bool reading_gates = false;
-    bool reading_connections = false;
-    size_t highest_gate_uid = num_inputs_tmp + 2 + num_outputs_tmp - 1;
-    while(getline(in_file, line)){
-        const bool matches_layer = regex_match(line, layer_re);
-        const bool matches_gate = regex_match(line, gate_re);
-        const bool matches_connection = regex_match(line, connection_re);
- 
-        //If the line doesn't match any valid syntax, return with error code
-        if(!matches_layer && !matches_gate && !matches_connection)
-            return 4;
-        
-        //Return value from the function called based on the line type
-        int ret_val_from_fn;
-        //Code to handle layer addition
-        if(matches_layer){
-            //If we're not reading layers anymore, return with error code
-            if(!reading_layers)
-                return 40;
-
-            ret_val_from_fn = loaded_circuit.add_layer(stoull(line.substr(2)));
-        }
-        //Code to handle gate addition
-        else if(matches_gate){
-            //If we were reading layers, now update the booleans to signal that the layers are finished and we're reading gates
-            if(reading_layers){
-                reading_layers = false;
-                reading_gates = true;
-                reading_connections = false;
-            }
-
-            //If we're not reading gates anymore, return with error code
-            if(!reading_gates)
-                return 40;
-
-            stringstream ss_line(line);
-            char dummy_char;
-            ss_line >> dummy_char;
-
-            size_t gate_uid_tmp;
-            string gate_type_str_tmp;
-            size_t num_layer_tmp;
-            ss_line >> gate_uid_tmp >> gate_type_str_tmp >> num_layer_tmp;
-
-            if(gate_uid_tmp > highest_gate_uid)
-                highest_gate_uid = gate_uid_tmp;
-
-            gate_type gt = gate_type::buffer;
-            if(gate_type_str_tmp == "BUF")
-                gt = gate_type::buffer;
-            else if(gate_type_str_tmp == "NOT")
-                gt = gate_type::not_gate;
-            else if(gate_type_str_tmp == "AND")
-                gt = gate_type::and_gate;
-            else if(gate_type_str_tmp == "OR")
-                gt = gate_type::or_gate;
-            else if(gate_type_str_tmp == "XOR")
-                gt = gate_type::xor_gate;
-            else if(gate_type_str_tmp == "NND")
-                gt = gate_type::nand_gate;
-            else if(gate_type_str_tmp == "NOR")
-                gt = gate_type::nor_gate;
-            else if(gate_type_str_tmp == "NXR")
-                gt = gate_type::nxor_gate;
-
-            ret_val_from_fn = loaded_circuit.add_gate_with_uid(gate_uid_tmp, gate(gt), num_layer_tmp);
-        }
-        //Code to handle connection addition
-        else if(matches_connection){
-            //If we were reading layers or gates, update the booleans to signal that the layers and/or gates are finished and we're reading connections
-            if(reading_layers || reading_gates){
-                reading_layers = false;
-                reading_gates = false;
-                reading_connections = true;
-            }
-
-            //If we're not reading connections anymore, return with error code
-            //This will probably never get executed, but I'm not sure
-            if(!reading_connections)
-                return 40;
-
-            stringstream ss_line(line);
-            char dummy_char;
-            ss_line >> dummy_char;
-
-            size_t gate_out_uid_tmp;
-            bool take_inv_output_tmp;
-            size_t gate_in_uid_tmp;
-            bool num_input_tmp;
-            ss_line >> gate_out_uid_tmp >> take_inv_output_tmp >> gate_in_uid_tmp >> num_input_tmp;
-
-            ret_val_from_fn = loaded_circuit.add_phantom_connection(gate_out_uid_tmp, take_inv_output_tmp, gate_in_uid_tmp, num_input_tmp);
-        }
-
-        //If the called function based on the line didn't return a 0 (success), return with error code
-        if(ret_val_from_fn != 0)
+
+    //The sizes are checked against the file before computing the size of the arrays, so that they can't overflow
+    const size_t payload_size = file.size() - sizeof(header);
+    if(header.num_gates > payload_size / sizeof(gate) || header.num_layers > payload_size / sizeof(uint64_t))
+        return 4;
+
+    const size_t gates_size = (header.num_gates * sizeof(gate) + 7) & ~size_t(7);
+    if(payload_size != gates_size + (header.num_gates + 2 * header.num_layers + 1) * sizeof(uint64_t))
+        return 4;
+
+    const char* payload = file.data() + sizeof(header);
+    if(binary_circuit_checksum(payload, payload_size) != header.checksum)
+        return 4;
+
+    //The arrays are copied, since they aren't guaranteed to be aligned if the file couldn't be mapped
+    const size_t num_gates_tmp = header.num_gates;
+    const size_t num_layers = header.num_layers;
+    vector<uint64_t> uids(num_gates_tmp), layer_numbers(num_layers), layer_offsets(num_layers + 1);
+    memcpy(uids.data(), payload + gates_size, num_gates_tmp * sizeof(uint64_t));
+    memcpy(layer_numbers.data(), payload + gates_size + num_gates_tmp * sizeof(uint64_t), num_layers * sizeof(uint64_t));
+    memcpy(layer_offsets.data(), payload + gates_size + (num_gates_tmp + num_layers) * sizeof(uint64_t), (num_layers + 1) * sizeof(uint64_t));
+
+    //Layers: in increasing order, with offsets that never decrease nor go past the gates, so that the loops below stay
+    //within the arrays
+    if(num_layers < 2)
+        return 5;
+    for(size_t l = 0; l < num_layers; ++l){
+        if((l > 0 && layer_numbers[l] <= layer_numbers[l - 1]) || layer_offsets[l] > layer_offsets[l + 1] || layer_offsets[l + 1] > num_gates_tmp)
             return 5;
     }
 
-    in_file.close();
-    loaded_circuit.m_next_gate_uid = highest_gate_uid + 1;
+    //From the input layer, with the constants and the inputs at the indices equal to their uids, to the output layer,
+    //covering all the gates
+    if(header.num_inputs + 2 > num_gates_tmp || layer_numbers[0] != 0 || layer_numbers[num_layers - 1] != static_cast<size_t>(-1) ||
+       layer_offsets[0] != 0 || layer_offsets[1] != header.num_inputs + 2 || layer_offsets[num_layers] != num_gates_tmp ||
+       num_gates_tmp - layer_offsets[num_layers - 1] != header.num_outputs)
+        return 5;
+
+    vector<size_t> gate_layers(num_gates_tmp);
+    for(size_t l = 0; l < num_layers; ++l){
+        for(size_t i = layer_offsets[l]; i < layer_offsets[l + 1]; ++i){
+            if((l == 0 && uids[i] != i) || (i > layer_offsets[l] && uids[i] <= uids[i - 1]) || uids[i] >= header.next_gate_uid)
+                return 5;
+            gate_layers[i] = l;
+        }
+    }
+
+    //Gates: valid types and flags, and inputs connected only to gates of previous layers
+    for(size_t i = 0; i < num_gates_tmp; ++i){
+        const char* record = payload + i * sizeof(gate);
+        uint32_t in[2];
+        memcpy(&in[0], record + offsetof(gate, in0), sizeof(uint32_t));
+        memcpy(&in[1], record + offsetof(gate, in1), sizeof(uint32_t));
+        if(uint8_t(record[offsetof(gate, type)]) > uint8_t(gate_type::nxor_gate) ||
+           uint8_t(record[offsetof(gate, inv_in0)]) > 1 || uint8_t(record[offsetof(gate, inv_in1)]) > 1)
+            return 5;
+
+        for(const auto& index_in : in){
+            if(index_in != NO_GATE && (index_in >= num_gates_tmp || gate_layers[index_in] >= gate_layers[i]))
+                return 5;
+        }
+    }
+
+    circuit loaded_circuit(0, 0);
+    loaded_circuit.m_inputs.assign(header.num_inputs, false);
+    loaded_circuit.m_outputs.assign(header.num_outputs, false);
+    loaded_circuit.m_layers.clear();
+    loaded_circuit.m_gates.resize(num_gates_tmp);
+    memcpy(static_cast<void*>(loaded_circuit.m_gates.data()), payload, num_gates_tmp * sizeof(gate));
+    loaded_circuit.m_gate_uids.assign(uids.begin(), uids.end());
+    loaded_circuit.m_gate_layers.resize(num_gates_tmp);
+    loaded_circuit.m_fanouts.assign(num_gates_tmp, vector<uint32_t>());
+    loaded_circuit.m_gate_indices.clear();
+    loaded_circuit.m_gate_indices.reserve(num_gates_tmp);
+
+    for(size_t l = 0; l < num_layers; ++l){
+        vector<uint32_t>& indices = loaded_circuit.m_layers[layer_numbers[l]].m_indices;
+        indices.resize(layer_offsets[l + 1] - layer_offsets[l]);
+        iota(indices.begin(), indices.end(), layer_offsets[l]);
+        fill(loaded_circuit.m_gate_layers.begin() + layer_offsets[l], loaded_circuit.m_gate_layers.begin() + layer_offsets[l + 1], layer_numbers[l]);
+    }
+
+    for(uint32_t i = 0; i < num_gates_tmp; ++i){
+        if(!loaded_circuit.m_gate_indices.emplace(uids[i], i).second)
+            return 5;
+    }
 
-    *this = loaded_circuit;
+    loaded_circuit.regen_fanouts();
+    loaded_circuit.m_next_gate_uid = header.next_gate_uid;
+    loaded_circuit.m_kernel = m_kernel;
+    loaded_circuit.m_event_driven = m_event_driven;
+    *this = move(loaded_circuit);
 
-    //Iterate over the phantom connection in the loaded circuit and based on that data, add connection to this circuit.
-    //This is because connections also update pointers inside gates, and if we were just to copy one object into another, then problems
-    //will arise when simulating the circuit.
-    for(const auto& c : loaded_circuit.m_phantom_connections){
-        if(add_connection(c.m_uid_output, c.m_inv_output, c.m_uid_input, c.m_num_input)){
-            set_io(num_inputs(), num_outputs());
-            return 6;
+    return 0;
+}
+
+//Function to import a netlist in the ISCAS-85/89 .bench format, replacing the current circuit only if the whole file is
+//valid. The file has the lines "INPUT(net)", "OUTPUT(net)" and "net = TYPE(net, net, ...)", in any order, with the types
+//BUF (or BUFF), NOT, AND, NAND, OR, NOR, XOR, XNOR and DFF. The gates with more than two inputs become trees of 2-input
+//gates, pairing first the inputs in the lowest layers, with the inverting gate at the root, so that the tree adds as
+//few layers as possible. The format has no layers, so every gate is placed in the layer after its highest input.
+//The flip-flops are cut, since the simulator is combinational: the output of every DFF becomes an input of the circuit,
+//after the ones declared by INPUT, and its input becomes an output, after the ones declared by OUTPUT.
+//Returns 1 if the file can't be opened, 4 if a line is badly formatted, 40 if a gate type isn't supported, 5 if a net
+//is defined twice or used without being defined, and 50 if the gates form a combinational loop.
+//In all the cases after 1, the line and column of the error are written in error_line and error_column
+int circuit::load_circuit_from_bench_file(const std::string& filename, size_t& error_line, size_t& error_column){
+    mapped_file file;
+    if(file.open(filename))
+        return 1;
+
+    bench_scanner scanner(file.data(), file.data() + file.size());
+    auto fail = [&](const int& code){
+        error_line = scanner.line();
+        error_column = scanner.column();
+        return code;
+    };
+
+    enum class net_kind : uint8_t{undefined, input, gate, flip_flop};
+    struct bench_type{const char* name; gate_type type;};
+    static const bench_type bench_types[] = {{"BUF", gate_type::buffer}, {"BUFF", gate_type::buffer}, {"NOT", gate_type::not_gate},
+                                             {"AND", gate_type::and_gate}, {"NAND", gate_type::nand_gate}, {"OR", gate_type::or_gate},
+                                             {"NOR", gate_type::nor_gate}, {"XOR", gate_type::xor_gate}, {"XNOR", gate_type::nxor_gate}};
+
+    //The nets are numbered as they're found, and every gate keeps its inputs in a range of gate_args
+    unordered_map<string_view, uint32_t> net_ids;
+    vector<net_kind> kinds;
+    vector<gate_type> types;
+    vector<uint32_t> args_begin, args_end;
+    vector<uint32_t> gate_args;
+    vector<size_t> lines, columns;                  //Where each net is defined, or first used if it isn't defined yet
+    vector<uint32_t> input_nets, output_nets, flip_flop_nets, flip_flop_input_nets;
+
+    const char* text_end = file.data() + file.size();
+    net_ids.reserve(count(file.data(), text_end, '\n') + 1);
+
+    auto net_id = [&](const string_view& name){
+        const auto [it, inserted] = net_ids.try_emplace(name, kinds.size());
+        if(inserted){
+            kinds.push_back(net_kind::undefined);
+            types.push_back(gate_type::buffer);
+            args_begin.push_back(0);
+            args_end.push_back(0);
+            lines.push_back(scanner.line());
+            columns.push_back(scanner.column());
+        }
+        return it->second;
+    };
+    auto define_net = [&](const uint32_t& net, const net_kind& kind, const size_t& line, const size_t& column){
+        if(kinds[net] != net_kind::undefined){
+            error_line = line;
+            error_column = column;
+            return false;
         }
+
+        kinds[net] = kind;
+        lines[net] = line;
+        columns[net] = column;
+        return true;
+    };
+
+    while(!scanner.at_end()){
+        if(scanner.end_of_line())
+            continue;
+
+        string_view name;
+        if(!scanner.name(name))
+            return fail(4);
+        const size_t name_line = scanner.line(), name_column = scanner.column();
+
+        if(scanner.peek('(')){
+            const bool is_input = bench_keyword(name, "INPUT");
+            if(!is_input && !bench_keyword(name, "OUTPUT"))
+                return fail(4);
+
+            scanner.symbol('(');
+            if(!scanner.name(name))
+                return fail(4);
+            const uint32_t net = net_id(name);
+            if(is_input){
+                if(!define_net(net, net_kind::input, scanner.line(), scanner.column()))
+                    return 5;
+                input_nets.push_back(net);
+            }
+            else
+                output_nets.push_back(net);
+
+            if(!scanner.symbol(')'))
+                return fail(4);
+        }
+        else {
+            if(!scanner.symbol('='))
+                return fail(4);
+            const uint32_t net = net_id(name);
+            string_view type_name;
+            if(!scanner.name(type_name))
+                return fail(4);
+            const bool is_flip_flop = bench_keyword(type_name, "DFF");
+            gate_type type = gate_type::buffer;
+            if(!is_flip_flop){
+                const auto it_type = find_if(begin(bench_types), end(bench_types), [&](const bench_type& t){return bench_keyword(type_name, t.name);});
+                if(it_type == end(bench_types))
+                    return fail(40);
+                type = it_type->type;
+            }
+
+            if(!scanner.symbol('('))
+                return fail(4);
+            const uint32_t first_arg = gate_args.size();
+            do {
+                if(!scanner.name(name))
+                    return fail(4);
+                gate_args.push_back(net_id(name));
+            } while(scanner.symbol(','));
+            if(!scanner.symbol(')'))
+                return fail(4);
+
+            //The flip-flops, the buffers and the NOT gates have a single input
+            if((is_flip_flop || type == gate_type::buffer || type == gate_type::not_gate) && gate_args.size() - first_arg != 1)
+                return fail(4);
+
+            if(!define_net(net, is_flip_flop ? net_kind::flip_flop : net_kind::gate, name_line, name_column))
+                return 5;
+            if(is_flip_flop){
+                flip_flop_nets.push_back(net);
+                flip_flop_input_nets.push_back(gate_args.back());
+                gate_args.pop_back();
+            }
+            else {
+                types[net] = type;
+                args_begin[net] = first_arg;
+                args_end[net] = gate_args.size();
+            }
+        }
+
+        if(!scanner.end_of_line())
+            return fail(4);
     }
 
-    set_inputs(vector<bool>(num_inputs(), false));
-    m_outputs = vector<bool>(num_outputs(), false);
+    const uint32_t num_nets = kinds.size();
+    for(uint32_t net = 0; net < num_nets; ++net){
+        if(kinds[net] == net_kind::undefined){
+            error_line = lines[net];
+            error_column = columns[net];
+            return 5;
+        }
+    }
+
+    //Sort the gates in topological order with a depth-first search, which finds the combinational loops
+    vector<uint32_t> order;
+    vector<uint8_t> visit_state(num_nets, 0);                  //0 not visited, 1 on the current path, 2 done
+    vector<pair<uint32_t, uint32_t>> path;                     //Nets on the path of the search, with their next input
+    order.reserve(num_nets);
+    for(uint32_t root = 0; root < num_nets; ++root){
+        if(kinds[root] != net_kind::gate || visit_state[root] != 0)
+            continue;
+
+        visit_state[root] = 1;
+        path.emplace_back(root, args_begin[root]);
+        while(!path.empty()){
+            auto& [net, next_arg] = path.back();
+            if(next_arg == args_end[net]){
+                visit_state[net] = 2;
+                order.push_back(net);
+                path.pop_back();
+                continue;
+            }
+
+            const uint32_t arg = gate_args[next_arg++];
+            if(kinds[arg] != net_kind::gate || visit_state[arg] == 2)
+                continue;
+            if(visit_state[arg] == 1){
+                error_line = lines[arg];
+                error_column = columns[arg];
+                return 50;
+            }
+
+            visit_state[arg] = 1;
+            path.emplace_back(arg, args_begin[arg]);
+        }
+    }
+
+    circuit loaded_circuit(input_nets.size() + flip_flop_nets.size(), output_nets.size() + flip_flop_nets.size());
+
+    //Index and layer of the gate driving each net
+    vector<uint32_t> net_indices(num_nets);
+    vector<size_t> net_layers(num_nets, 0);
+    for(size_t i = 0; i < input_nets.size(); ++i)
+        net_indices[input_nets[i]] = i + 2;
+    for(size_t i = 0; i < flip_flop_nets.size(); ++i)
+        net_indices[flip_flop_nets[i]] = input_nets.size() + i + 2;
+
+    size_t num_gates_tmp = loaded_circuit.m_gates.size();
+    for(const auto& net : order)
+        num_gates_tmp += max<size_t>(args_end[net] - args_begin[net], 2) - 1;
+    loaded_circuit.m_gates.reserve(num_gates_tmp);
+    loaded_circuit.m_gate_uids.reserve(num_gates_tmp);
+    loaded_circuit.m_gate_layers.reserve(num_gates_tmp);
+    loaded_circuit.m_fanouts.reserve(num_gates_tmp);
+    loaded_circuit.m_gate_indices.reserve(num_gates_tmp);
+
+    auto add_tree_gate = [&](const gate_type& type, const pair<size_t, uint32_t>& in0, const pair<size_t, uint32_t>& in1){
+        const size_t num_layer = max(in0.first, in1.first) + 1;
+        loaded_circuit.add_layer(num_layer);
+        const uint32_t index = loaded_circuit.create_gate(loaded_circuit.m_next_gate_uid++, type, num_layer);
+        loaded_circuit.m_gates[index].in0 = in0.second;
+        loaded_circuit.m_gates[index].in1 = in1.second;
+        return make_pair(num_layer, index);
+    };
+
+    //The operands of a tree are kept in a min-heap by layer, each one with the index of the gate driving it
+    vector<pair<size_t, uint32_t>> operands;
+    const auto higher_layer = [](const pair<size_t, uint32_t>& a, const pair<size_t, uint32_t>& b){return a.first > b.first;};
+    for(const auto& net : order){
+        operands.clear();
+        for(uint32_t a = args_begin[net]; a < args_end[net]; ++a)
+            operands.emplace_back(net_layers[gate_args[a]], net_indices[gate_args[a]]);
+
+        pair<size_t, uint32_t> root;
+        if(operands.size() == 1){
+            //With a single input, the AND, OR and XOR gates are buffers and their inverted versions are NOT gates
+            const bool inverting = (types[net] == gate_type::not_gate || types[net] == gate_type::nand_gate ||
+                                    types[net] == gate_type::nor_gate || types[net] == gate_type::nxor_gate);
+            root = add_tree_gate(inverting ? gate_type::not_gate : gate_type::buffer, operands[0], make_pair(0, NO_GATE));
+        }
+        else {
+            gate_type tree_type = types[net];
+            if(tree_type == gate_type::nand_gate)
+                tree_type = gate_type::and_gate;
+            else if(tree_type == gate_type::nor_gate)
+                tree_type = gate_type::or_gate;
+            else if(tree_type == gate_type::nxor_gate)
+                tree_type = gate_type::xor_gate;
+
+            make_heap(operands.begin(), operands.end(), higher_layer);
+            while(operands.size() > 2){
+                pop_heap(operands.begin(), operands.end(), higher_layer);
+                const auto in0 = operands.back();
+                operands.pop_back();
+                pop_heap(operands.begin(), operands.end(), higher_layer);
+                const auto in1 = operands.back();
+                operands.back() = add_tree_gate(tree_type, in0, in1);
+                push_heap(operands.begin(), operands.end(), higher_layer);
+            }
+            root = add_tree_gate(types[net], operands[0], operands[1]);
+        }
+
+        net_layers[net] = root.first;
+        net_indices[net] = root.second;
+    }
+
+    const vector<uint32_t>& output_layer = loaded_circuit.m_layers[static_cast<size_t>(-1)].m_indices;
+    for(size_t o = 0; o < output_nets.size(); ++o)
+        loaded_circuit.m_gates[output_layer[o]].in0 = net_indices[output_nets[o]];
+    for(size_t i = 0; i < flip_flop_input_nets.size(); ++i)
+        loaded_circuit.m_gates[output_layer[output_nets.size() + i]].in0 = net_indices[flip_flop_input_nets[i]];
+
+    loaded_circuit.regen_fanouts();
+    loaded_circuit.m_kernel = m_kernel;
+    loaded_circuit.m_event_driven = m_event_driven;
+    *this = move(loaded_circuit);
+
+    return 0;
+}
+
+//Function to regenerate the fanouts of all the gates from their inputs, after they've been modified directly
+int circuit::regen_fanouts(){
+    for(auto& fanout : m_fanouts)
+        fanout.clear();
+
+    for(const auto& l : m_layers){
+        if(l.first == 0)
+            continue;
+
+        for(const auto& i : l.second.m_indices){
+            const gate& g = m_gates[i];
+            if(g.in0 != NO_GATE)
+                m_fanouts[g.in0].push_back(2 * i);
+            if(g.in1 != NO_GATE)
+                m_fanouts[g.in1].push_back(2 * i + 1);
+        }
+    }
+
+    m_compiled_stale = true;
 
     return 0;
-}
\ No newline at end of file
+}
@@ -5,42 +5,114 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <memory>
+#include <span>
+#include <cstdint>
 
 #include "gates.hpp"
+#include "kernels.hpp"
+#include "codegen.hpp"
+#include "truth_table.hpp"
+#include "async_writer.hpp"
+#include "faults.hpp"
+#include "testability.hpp"
+#include "bdd.hpp"
+#include "aig.hpp"
+#include "sampling.hpp"
+#include "activity.hpp"
+#include "optimization.hpp"
+#include "thread_pool.hpp"
+
+#define TRUTH_TABLE_WORDS_PER_NET 8                 //Words carried by each net while generating the truth table
+#define TRUTH_TABLE_ROWS_PER_BLOCK (1 << 16)        //Rows of the truth table simulated and formatted by a thread at once
+#define LAYER_PARALLEL_MIN_GATES 4096               //Layers with less gates than this aren't split between threads
+#define BATCH_WORDS_PER_NET 8                       //Words carried by each net while simulating a batch of vectors
+#define STIMULUS_VECTORS_PER_BATCH 4096             //Vectors of a stimulus simulated and printed at once
+#define STIMULUS_CHUNK_SIZE (1 << 22)               //Bytes read at once from a stimulus stream that can't be mapped
+#define FAULT_SIM_WORDS_PER_NET 4                   //Words carried by each net while simulating the faults
+#define SAMPLING_WORDS_PER_NET 8                    //Words carried by each net while simulating random input vectors
+#define ACTIVITY_WORDS_PER_NET 8                    //Words carried by each net while counting the toggles of the gates
 
 class circuit{
     private:
         struct layer{
-            std::map<size_t, gate> m_gates;
+            std::vector<uint32_t> m_indices;        //Indices in m_gates of the gates of the layer, sorted by uid
         };
         
-        struct connection{           
-            size_t m_uid_output;
-            bool m_inv_output;
-            size_t m_uid_input;
-            bool m_num_input;
-
-            connection(const size_t& uid_out, const bool& inv, const size_t& uid_in, const bool& num_in) :
-                m_uid_output(uid_out),
-                m_inv_output(inv),
-                m_uid_input(uid_in),
-                m_num_input(num_in)
-            {}
+        struct flat_netlist{
+            std::vector<gate_op> m_ops;             //Topologically ordered. m_ops[i] drives net i + (number of inputs) + 2
+            std::vector<uint32_t> m_output_nets;    //Nets driving the buffers of the output layer, in order
+            std::vector<uint32_t> m_layer_offsets;  //Index of the first op of each layer, followed by the number of ops
+            std::vector<uint32_t> m_op_layers;      //Index of the layer of each op (in m_layer_offsets)
+            std::vector<uint32_t> m_fanout_offsets; //The ops reading net i are m_fanout_ops[m_fanout_offsets[i]] up to
+            std::vector<uint32_t> m_fanout_ops;     //m_fanout_ops[m_fanout_offsets[i + 1] - 1]
+            std::vector<size_t> m_net_uids;         //Uid of the gate driving each net
+            size_t m_num_nets;
+        };
+
+        struct fault_target{
+            uint32_t m_net;                         //Net driven by the faulty output, or by the gate with the faulty input
+            uint8_t m_forced_inputs;                //Inputs of the op that are stuck: bit 0 for in0, bit 1 for in1
+            bool m_stuck_at;
+        };
+
+        struct fault_workspace{
+            std::vector<uint64_t> m_faulty_nets;
+            std::vector<uint8_t> m_op_scheduled;
+            std::vector<std::vector<uint32_t>> m_events;
+            std::vector<uint32_t> m_touched_nets;
         };
 
         std::vector<bool> m_inputs;
         std::vector<bool> m_outputs;
         std::map<size_t, layer> m_layers;
-        std::map<size_t, size_t> m_gates_in_layers; 
-        std::vector<connection> m_connections;
-        std::vector<connection> m_phantom_connections;  //Used only when loading a circuit from file. Phantom because it doesn't affect the gates
+        std::vector<gate> m_gates;                      //All the gates, referenced by index (see create_gate)
+        std::vector<size_t> m_gate_uids;                //Uid of the gate at each index
+        std::vector<size_t> m_gate_layers;              //Layer of the gate at each index
+        std::vector<uint32_t> m_free_indices;           //Indices of the deleted gates, reused by the next ones
+        std::unordered_map<size_t, uint32_t> m_gate_indices;    //Index of the gate with each uid
+        std::vector<std::vector<uint32_t>> m_fanouts;  //Inputs connected to each gate, as 2 * (index of the gate) + input
+        flat_netlist m_compiled;
+        bool m_compiled_stale;                          //Set by every edit, the circuit gets recompiled on the next simulation
+        std::vector<uint64_t> m_net_values;             //Values of the nets of m_compiled after the last simulation
+        std::shared_ptr<native_evaluator> m_native;     //If present, used instead of the kernels. Dropped on recompilation
+        bool m_event_driven;
+        bool m_net_values_valid;                        //True if m_net_values are consistent with the last inputs simulated
+        std::vector<uint8_t> m_op_scheduled;            //Used by the event-driven simulation
+        std::vector<std::vector<uint32_t>> m_events;    //Ops scheduled for evaluation, for each layer
+        size_t m_first_event_layer;
+        size_t m_last_event_layer;
+        std::vector<uint64_t> m_batch_nets;             //Buffers of simulate_batch, kept to avoid allocating them at every call
+        std::vector<uint64_t> m_batch_outputs;
+        mutable thread_pool m_pool;                     //Threads of the parallel simulations, kept between them
 
         size_t m_next_gate_uid;
+        sim_kernel m_kernel;
 
-        void set_all_gates_to_status(const status& s);
         std::string gate_type_to_str(const gate_type& g);
+        uint32_t gate_index(const size_t& uid) const {return m_gate_indices.at(uid);}
+        size_t layer_of(const size_t& uid) const {return m_gate_layers[m_gate_indices.at(uid)];}
+        uint32_t create_gate(const size_t& uid, const gate_type& type, const size_t& num_layer);
+        void destroy_gate(const uint32_t& index);
+        void connect_input(const uint32_t& index, const bool& num_input, const uint32_t& index_out, const bool& inv);
+        void disconnect_input(const uint32_t& index, const bool& num_input);
         int add_gate_with_uid(const size_t& uid, const gate& g, const size_t& num_layer);
-        int add_phantom_connection(const size_t& gate_out_uid, const bool& take_inv_output, const size_t& gate_in_uid, const bool& num_input);
+        int build_flat_netlist(flat_netlist& fn);
+        void schedule_fanout(const uint32_t& net);
+        void simulate_events();
+        void propagate_events();
+        void run_ops(uint64_t* nets, const size_t& words_per_net, const size_t& num_threads) const;
+        void run_wide_pass(uint64_t* nets, uint64_t* outputs, const size_t& words_per_net, const size_t& num_threads = 1) const;
+        void format_truth_table_rows(const uint64_t& first_row, const uint64_t& num_rows, std::string& text) const;
+        void pack_vectors_in_nets(std::span<const uint64_t> inputs, const size_t& num_vectors, const size_t& first_vector, uint64_t* nets, const size_t& words_per_net) const;
+        void pack_truth_table_rows(const uint64_t& first_row, const uint64_t& num_rows, uint64_t* columns) const;
+        int parse_stimulus_line(const char* text, const char* text_end, uint64_t* vector_inputs) const;
+        void enumerate_faults(std::vector<fault>& faults, std::vector<fault_target>& targets);
+        size_t propagate_fault(const fault_target& target, const uint64_t* good_nets, const uint64_t* valid_lanes, const std::vector<uint8_t>& is_output_net, fault_workspace& ws) const;
+        int simulate_stimulus_text(const char*& text, const char* text_end, const bool& last_chunk, async_writer<std::string>& writer, size_t& num_lines);
+        void remove_gates(const std::vector<size_t>& uids);
+        void find_unreachable_gates(std::vector<size_t>& uids) const;
 
     public:
         circuit(const size_t& num_inputs, const size_t& num_outputs);
@@ -50,6 +122,9 @@ class circuit{
 
         size_t num_inputs() const {return m_inputs.size();}
         size_t num_outputs() const {return m_outputs.size();}
+        size_t num_gates() const {return m_gate_indices.size() - m_inputs.size() - m_outputs.size() - 2;}
+        size_t input_words_per_vector() const {return (m_inputs.size() + 63) / 64;}
+        size_t output_words_per_vector() const {return (m_outputs.size() + 63) / 64;}
 
         int add_layer(const size_t& num_layer);
         int add_gate(const gate& g, const size_t& num_layer);
@@ -72,21 +147,53 @@ class circuit{
         int delete_connection(const size_t& gate_out_uid, const bool& take_inv_output, const size_t& gate_in_uid, const bool& num_input);
         int delete_connection(const size_t& num_layer_output, const size_t& gate_out_uid, const bool& take_inv_output, const size_t& num_layer_input, const size_t& gate_in_uid, const bool& num_input);
 
+        int compile();
+        int compile_native();
+        void drop_native() {m_native.reset();}
+        bool uses_native() const {return m_native != nullptr;}
+        void set_event_driven(const bool& event_driven) {m_event_driven = event_driven;}
+        bool is_event_driven() const {return m_event_driven;}
+
         int set_inputs(const std::vector<bool>& inputs);
         std::vector<bool> read_inputs() const {return m_inputs;}
-        std::vector<bool> read_outputs();
-
-        int simulate_circuit(const std::vector<bool>& inputs);
-        int simulate_circuit();
-        int gen_truth_table(std::ostream& os = std::cout);
+        std::vector<bool> read_outputs() const {return m_outputs;}
+
+        int simulate_circuit(const std::vector<bool>& inputs, const size_t& num_threads = 1);
+        int simulate_circuit(const size_t& num_threads = 1);
+        int simulate_circuit_64(const std::vector<uint64_t>& inputs, std::vector<uint64_t>& outputs);
+        int simulate_circuit_wide(const std::vector<uint64_t>& inputs, std::vector<uint64_t>& outputs, const size_t& words_per_net, const size_t& num_threads = 1);
+        int simulate_batch(std::span<const uint64_t> inputs, std::span<uint64_t> outputs, const size_t& num_vectors);
+        int simulate_stimulus(std::istream& is, std::ostream& os, size_t& num_lines);
+        int simulate_stimulus_file(const std::string& filename, std::ostream& os, size_t& num_lines);
+        int simulate_faults(std::span<const uint64_t> inputs, const size_t& num_vectors, fault_sim_report& report, const size_t& num_threads = 1);
+        int analyze_testability(std::map<size_t, gate_testability>& results);
+        int build_output_bdds(bdd_manager& manager, std::vector<uint32_t>& outputs, const bool& reorder = false);
+        int sample_signal_probabilities(const uint64_t& num_samples, const uint64_t& seed, sampling_report& report, const size_t& num_threads = 1);
+        int simulate_switching_activity(std::span<const uint64_t> inputs, const size_t& num_vectors, switching_activity_report& report, const size_t& num_threads = 1);
+        int load_stimulus_file(const std::string& filename, std::vector<uint64_t>& inputs, size_t& num_vectors, size_t& num_lines) const;
+
+        int set_sim_kernel(const sim_kernel& k);
+        sim_kernel get_sim_kernel() const {return m_kernel;}
+        int gen_truth_table(std::ostream& os = std::cout, const size_t& num_threads = 1);
+        int gen_truth_table_gray(std::ostream& os = std::cout);
+        int gen_truth_table_packed(std::ostream& os, const size_t& num_threads = 1);
+
+        int optimize(optimization_report& report);
+        int sweep_equivalent_gates(const uint64_t& seed, sweep_report& report);
+        int to_aig(aig& graph);
+        int from_aig(const aig& graph);
 
         void print_circuit(const bool& print_gates = true, const bool& print_connections = true, std::ostream& os = std::cout);
         void list_unconnected(std::ostream& os = std::cout);
 
         int save_circuit_to_file(const std::string& filename);
         int load_circuit_from_file(const std::string& filename);
+        int load_circuit_from_file(const std::string& filename, size_t& error_line, size_t& error_column);
+        int save_circuit_to_binary_file(const std::string& filename);
+        int load_circuit_from_binary_file(const std::string& filename);
+        int load_circuit_from_bench_file(const std::string& filename, size_t& error_line, size_t& error_column);
 
-        int regen_connection_vector();
+        int regen_fanouts();
 };
 
 #endif
\ No newline at end of file
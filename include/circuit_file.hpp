@@ -0,0 +1,34 @@
+#ifndef CIRCUIT_FILE_HPP
+#define CIRCUIT_FILE_HPP
+
+#include <cstdint>
+
+#define BINARY_CIRCUIT_MAGIC "DCSCIRC"              //Followed by the null terminator, it fills the 8 bytes of the magic
+#define BINARY_CIRCUIT_VERSION 1
+#define BINARY_CIRCUIT_EXTENSION ".cbin"            //Files saved and loaded in the binary format by "vc" and "lc"
+#define BENCH_CIRCUIT_EXTENSION ".bench"            //Netlists in the ISCAS .bench format, imported by "lc"
+
+//----------------------------------------------------------------------------------------------------------------------
+//Binary format of the circuits written by circuit::save_circuit_to_binary_file.
+//The header is followed by four arrays, each padded with zeros to a multiple of 8 bytes:
+//- the records of all the gates (struct gate), in their in-memory layout, sorted by layer and then by uid, so that the
+//  inputs of every gate are the indices in this array of the gates connected to them. The input layer comes first,
+//  the output layer last
+//- the uids of the gates, as uint64_t, in the same order
+//- the numbers of the layers, as uint64_t, in increasing order (the output layer is -1)
+//- the index of the first gate of each layer, as uint64_t, followed by the number of gates
+//The checksum is computed over all the bytes following the header, read as uint64_t words.
+//Every field is stored in the byte order of the machine that wrote the file
+struct binary_circuit_header{
+    char magic[8];
+    uint32_t version;
+    uint32_t gate_size;                             //Size of the records of the gates, which depends on the machine
+    uint64_t num_inputs;
+    uint64_t num_outputs;
+    uint64_t num_gates;                             //Including the constants, the inputs and the output buffers
+    uint64_t num_layers;                            //Including the input and output layers
+    uint64_t next_gate_uid;
+    uint64_t checksum;
+};
+
+#endif
@@ -0,0 +1,190 @@
+#include "codegen.hpp"
+#include "gates.hpp"
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <cstdlib>
+#include <cerrno>
+#include <filesystem>
+
+#if __has_include(<dlfcn.h>) && __has_include(<unistd.h>) && __has_include(<spawn.h>) && __has_include(<sys/wait.h>) && __has_include(<fcntl.h>)
+#include <dlfcn.h>
+#include <unistd.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#define HAS_DLOPEN
+
+extern char** environ;
+#endif
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------------------------
+//Private members
+
+//Function to write the C++ source of the evaluator. Every net becomes a local variable, so that the compiler is free to
+//keep them in registers, and the gates are evaluated once for every word of the nets
+string native_evaluator::gen_source(const vector<gate_op>& ops, const vector<uint32_t>& output_nets, const size_t& num_inputs){
+    stringstream src;
+
+    src << "#include <cstdint>\n";
+    src << "#include <cstddef>\n\n";
+    src << "extern \"C\" void dcs_eval(const uint64_t* in, uint64_t* out, size_t words){\n";
+    src << "    for(size_t w = 0; w < words; ++w){\n";
+    src << "        const uint64_t n0 = 0;\n";
+    src << "        const uint64_t n1 = ~uint64_t(0);\n";
+    for(size_t i = 0; i < num_inputs; ++i)
+        src << "        const uint64_t n" << i + 2 << " = in[" << i << " * words + w];\n";
+
+    for(const auto& op : ops){
+        const string in0 = (op.inv_in0 ? "~n" : "n") + to_string(op.net_in0);
+        const string in1 = (op.inv_in1 ? "~n" : "n") + to_string(op.net_in1);
+
+        src << "        const uint64_t n" << op.net_out << " = ";
+        switch(op.type){
+            case gate_type::buffer:
+                src << in0;
+                break;
+            case gate_type::not_gate:
+                src << "~(" << in0 << ")";
+                break;
+            case gate_type::and_gate:
+                src << in0 << " & " << in1;
+                break;
+            case gate_type::or_gate:
+                src << in0 << " | " << in1;
+                break;
+            case gate_type::xor_gate:
+                src << in0 << " ^ " << in1;
+                break;
+            case gate_type::nand_gate:
+                src << "~(" << in0 << " & " << in1 << ")";
+                break;
+            case gate_type::nor_gate:
+                src << "~(" << in0 << " | " << in1 << ")";
+                break;
+            case gate_type::nxor_gate:
+                src << "~(" << in0 << " ^ " << in1 << ")";
+                break;
+        }
+        src << ";\n";
+    }
+
+    for(size_t i = 0; i < output_nets.size(); ++i)
+        src << "        out[" << i << " * words + w] = n" << output_nets[i] << ";\n";
+    src << "    }\n";
+    src << "}\n";
+
+    return src.str();
+}
+
+#ifdef HAS_DLOPEN
+//Function to run a command, given as its words, without going through a shell and discarding its output.
+//Returns the exit status of the command, or -1 if it can't be run or doesn't exit normally
+static int run_command(const vector<string>& words){
+    vector<char*> argv;
+    for(const auto& w : words)
+        argv.push_back(const_cast<char*>(w.c_str()));
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    if(posix_spawn_file_actions_init(&actions) != 0)
+        return -1;
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+
+    pid_t pid;
+    const int spawn_ret_val = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if(spawn_ret_val != 0)
+        return -1;
+
+    int status;
+    while(waitpid(pid, &status, 0) < 0){
+        if(errno != EINTR)
+            return -1;
+    }
+
+    return (WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+}
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+//Public members
+
+native_evaluator::~native_evaluator(){
+#ifdef HAS_DLOPEN
+    if(m_handle != nullptr)
+        dlclose(m_handle);
+#endif
+}
+
+//Function to generate, build and load the evaluator. The compiler is taken from the CXX environment variable, "c++" if
+//it's not set. CXX isn't run by a shell: it's split on the blanks in the compiler and its first arguments (e.g.
+//"ccache g++"), so it can't contain quotes, redirections or other shell syntax.
+//The source and the shared object are written in a new directory only accessible by the user (see mkdtemp), so that
+//the other users can't replace them between the build and the load, which is removed afterwards.
+//Returns 1 if the compiler can't be run or fails, 2 if the resulting shared object can't be loaded
+int native_evaluator::build(const vector<gate_op>& ops, const vector<uint32_t>& output_nets, const size_t& num_inputs){
+#ifdef HAS_DLOPEN
+    string dir_template = (filesystem::temp_directory_path() / "dcs_eval_XXXXXX").string();
+    if(mkdtemp(dir_template.data()) == nullptr)
+        return 1;
+
+    const filesystem::path build_dir = dir_template;
+    const filesystem::path src_path = build_dir / "eval.cpp";
+    const filesystem::path lib_path = build_dir / "eval.so";
+    error_code ec;
+
+    {
+        ofstream src_file(src_path);
+        if(!src_file.is_open()){
+            filesystem::remove_all(build_dir, ec);
+            return 1;
+        }
+
+        src_file << gen_source(ops, output_nets, num_inputs);
+    }
+
+    const char* cxx_env = getenv("CXX");
+    stringstream cxx(cxx_env != nullptr ? cxx_env : "");
+    vector<string> command;
+    for(string word; cxx >> word;)
+        command.push_back(word);
+    if(command.empty())
+        command.push_back("c++");
+    command.insert(command.end(), {"-O2", "-march=native", "-shared", "-fPIC", "-o", lib_path.string(), src_path.string()});
+
+    if(run_command(command) != 0){
+        filesystem::remove_all(build_dir, ec);
+        return 1;
+    }
+
+    //The shared object can be removed as soon as it's loaded
+    void* handle = dlopen(lib_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    filesystem::remove_all(build_dir, ec);
+    if(handle == nullptr)
+        return 2;
+
+    void* sym = dlsym(handle, "dcs_eval");
+    if(sym == nullptr){
+        dlclose(handle);
+        return 2;
+    }
+
+    if(m_handle != nullptr)
+        dlclose(m_handle);
+    m_handle = handle;
+    m_eval = reinterpret_cast<eval_fn>(sym);
+
+    return 0;
+#else
+    (void)ops;
+    (void)output_nets;
+    (void)num_inputs;
+    return 1;
+#endif
+}
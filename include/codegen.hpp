@@ -0,0 +1,38 @@
+#ifndef CODEGEN_HPP
+#define CODEGEN_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "gates.hpp"
+
+//----------------------------------------------------------------------------------------------------------------------
+//Evaluator specialized for a single circuit.
+//The compiled form of the circuit is emitted as straight-line C++ (one statement per gate, on 64 bit words), which is
+//built in a shared object by the compiler installed on the machine and then loaded with dlopen.
+//The generated function has the same interface as circuit::simulate_circuit_wide
+class native_evaluator{
+    public:
+        typedef void (*eval_fn)(const uint64_t* inputs, uint64_t* outputs, size_t words_per_net);
+
+    private:
+        void* m_handle;
+        eval_fn m_eval;
+
+        static std::string gen_source(const std::vector<gate_op>& ops, const std::vector<uint32_t>& output_nets, const size_t& num_inputs);
+
+    public:
+        native_evaluator() : m_handle(nullptr), m_eval(nullptr) {};
+        ~native_evaluator();
+
+        native_evaluator(const native_evaluator&) = delete;
+        native_evaluator& operator=(const native_evaluator&) = delete;
+
+        int build(const std::vector<gate_op>& ops, const std::vector<uint32_t>& output_nets, const size_t& num_inputs);
+
+        void eval(const uint64_t* inputs, uint64_t* outputs, size_t words_per_net) const {m_eval(inputs, outputs, words_per_net);}
+};
+
+#endif
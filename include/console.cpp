@@ -2,10 +2,16 @@
 #include <cctype>
 #include <vector>
 #include <iostream>
+#include <fstream>
+#include <map>
+#include <iomanip>
 #include <algorithm>
 
 #include "circuit.hpp"
 #include "console.hpp"
+#include "kernels.hpp"
+#include "truth_table.hpp"
+#include "circuit_file.hpp"
 
 #include "help.hpp"
 
@@ -69,6 +75,16 @@ int console::validate_bool(const string& input_str, bool& ouput_bool, const stri
     return ret_val;
 }
 
+//Function to check if a circuit file is in the binary format, which is chosen by its extension
+bool console::is_binary_circuit_file(const string& filename){
+    return filename.ends_with(BINARY_CIRCUIT_EXTENSION);
+}
+
+//Function to check if a circuit file is a netlist in the ISCAS .bench format, which is chosen by its extension
+bool console::is_bench_circuit_file(const string& filename){
+    return filename.ends_with(BENCH_CIRCUIT_EXTENSION);
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 //Private command execution methods
 
@@ -118,8 +134,34 @@ void console::print_help(const vector<string>& command_and_args){
             m_os << ro_help << endl;
         else if(help_arg == "sc")
             m_os << sc_help << endl;
+        else if(help_arg == "ssf")
+            m_os << ssf_help << endl;
+        else if(help_arg == "fs")
+            m_os << fs_help << endl;
+        else if(help_arg == "sa")
+            m_os << sa_help << endl;
+        else if(help_arg == "ta")
+            m_os << ta_help << endl;
+        else if(help_arg == "sample")
+            m_os << sample_help << endl;
+        else if(help_arg == "bdd")
+            m_os << bdd_help << endl;
+        else if(help_arg == "optimize")
+            m_os << optimize_help << endl;
+        else if(help_arg == "sweep")
+            m_os << sweep_help << endl;
+        else if(help_arg == "aig")
+            m_os << aig_help << endl;
         else if(help_arg == "gtt")
             m_os << gtt_help << endl;
+        else if(help_arg == "qtt")
+            m_os << qtt_help << endl;
+        else if(help_arg == "sk")
+            m_os << sk_help << endl;
+        else if(help_arg == "nc")
+            m_os << nc_help << endl;
+        else if(help_arg == "ed")
+            m_os << ed_help << endl;
         else if(help_arg == "pc")
             m_os << pc_help << endl;
         else if(help_arg == "lu")
@@ -925,24 +967,35 @@ void console::read_outputs(const std::vector<std::string>& command_and_args){
 //Handle circuit simulation
 void console::simulate_circuit(const std::vector<std::string>& command_and_args){
     string inputs_str;
+    size_t num_threads = 1;
     int ret_val_from_fn = -10;
 
-    switch(command_and_args.size()){
+    //The number of threads, if specified, is always the last argument
+    vector<string> args = command_and_args;
+    if(args.size() >= 3 && args[args.size() - 2] == "-j"){
+        if(validate_uint(args.back(), num_threads, "ERR: the specified number of threads can't be converted to uint"))
+            return;
+
+        args.resize(args.size() - 2);
+    }
+
+    switch(args.size()){
         case 1:
-            ret_val_from_fn = m_circuit.simulate_circuit();
+            ret_val_from_fn = m_circuit.simulate_circuit(num_threads);
             break;
 
         case 2:
-            inputs_str = command_and_args[1];
+            inputs_str = args[1];
 
             m_os << "Set inputs: ";
             set_inputs(vector<string>{"si", inputs_str});
             m_os << "Simulation: ";
-            ret_val_from_fn = m_circuit.simulate_circuit();
+            ret_val_from_fn = m_circuit.simulate_circuit(num_threads);
             break;
 
         default:
-            m_os << "ERR: the command \"sc\" requires 0 or 1 argument" << endl;
+            m_os << "ERR: the command \"sc\" requires 0, 1, 2 or 3 arguments" << endl;
+            return;
             break;
     }
 
@@ -952,16 +1005,873 @@ void console::simulate_circuit(const std::vector<std::string>& command_and_args)
         m_os << "ERR: some gates in the circuit have their inputs not connected" << endl;
 }
 
+//Handle simulation of a stimulus file
+void console::simulate_stimulus_file(const std::vector<std::string>& command_and_args){
+    if(command_and_args.size() != 2 && command_and_args.size() != 3){
+        m_os << "ERR: the command \"ssf\" requires 1 or 2 arguments" << endl;
+        return;
+    }
+
+    const string stimulus_filename = command_and_args[1];
+
+    ofstream output_file;
+    if(command_and_args.size() == 3){
+        output_file.open(command_and_args[2]);
+        if(!output_file.is_open()){
+            m_os << "ERR: output file can't be opened" << endl;
+            return;
+        }
+    }
+    ostream& os = (output_file.is_open() ? output_file : m_os);
+
+    size_t num_lines = 0;
+    const int ret_val_from_fn = (stimulus_filename == "-" ?
+                                 m_circuit.simulate_stimulus(cin, os, num_lines) :
+                                 m_circuit.simulate_stimulus_file(stimulus_filename, os, num_lines));
+    os.flush();
+
+    switch(ret_val_from_fn){
+        case 0:
+            m_os << VALID_COMMAND_MSG << endl;
+            break;
+
+        case 1:
+            m_os << "ERR: stimulus file can't be opened" << endl;
+            break;
+
+        case 2:
+            m_os << "ERR: some gates in the circuit have their inputs not connected" << endl;
+            break;
+
+        case 3:
+            m_os << "ERR: line " << num_lines << " of the stimulus isn't a valid input vector" << endl;
+            break;
+
+        default:
+            m_os << GENERIC_INVALID_COMMAND_MSG << endl;
+            break;
+    }
+}
+
+//Handle fault simulation
+void console::simulate_faults(const std::vector<std::string>& command_and_args){
+    size_t num_threads = 1;
+
+    //The number of threads, if specified, is always the last argument
+    vector<string> args = command_and_args;
+    if(args.size() >= 4 && args[args.size() - 2] == "-j"){
+        if(validate_uint(args.back(), num_threads, "ERR: the specified number of threads can't be converted to uint"))
+            return;
+
+        args.resize(args.size() - 2);
+    }
+
+    if(args.size() != 2 && args.size() != 3){
+        m_os << "ERR: the command \"fs\" requires 1, 2, 3 or 4 arguments" << endl;
+        return;
+    }
+
+    vector<uint64_t> inputs;
+    size_t num_vectors = 0;
+    size_t num_lines = 0;
+    switch(m_circuit.load_stimulus_file(args[1], inputs, num_vectors, num_lines)){
+        case 0:
+            break;
+
+        case 1:
+            m_os << "ERR: stimulus file can't be opened" << endl;
+            return;
+
+        case 3:
+            m_os << "ERR: line " << num_lines << " of the stimulus isn't a valid input vector" << endl;
+            return;
+
+        default:
+            m_os << GENERIC_INVALID_COMMAND_MSG << endl;
+            return;
+    }
+
+    fault_sim_report report;
+    if(m_circuit.simulate_faults(inputs, num_vectors, report, num_threads)){
+        m_os << "ERR: some gates in the circuit have their inputs not connected" << endl;
+        return;
+    }
+
+    m_os << "Vectors: " << num_vectors << ", faults: " << report.faults.size() << ", detected: " << report.num_detected;
+    m_os << ", coverage: " << 100.0 * report.coverage() << "%" << endl;
+
+    if(args.size() == 3){
+        ofstream report_file(args[2]);
+        if(!report_file.is_open()){
+            m_os << "ERR: output file can't be opened" << endl;
+            return;
+        }
+
+        const string site_str[] = {"out", "in0", "in1"};
+        for(size_t f = 0; f < report.faults.size(); ++f){
+            const fault& flt = report.faults[f];
+            report_file << flt.uid_gate << " " << site_str[static_cast<int>(flt.site)] << " sa" << flt.stuck_at << " ";
+            if(report.detecting_vectors[f] == FAULT_NOT_DETECTED)
+                report_file << "-" << "\n";
+            else
+                report_file << report.detecting_vectors[f] << "\n";
+        }
+    }
+
+    m_os << VALID_COMMAND_MSG << endl;
+}
+
+//Handle switching activity analysis
+void console::simulate_switching_activity(const std::vector<std::string>& command_and_args){
+    size_t num_threads = 1;
+
+    //The number of threads, if specified, is always the last argument
+    vector<string> args = command_and_args;
+    if(args.size() >= 4 && args[args.size() - 2] == "-j"){
+        if(validate_uint(args.back(), num_threads, "ERR: the specified number of threads can't be converted to uint"))
+            return;
+
+        args.resize(args.size() - 2);
+    }
+
+    if(args.size() != 2 && args.size() != 3){
+        m_os << "ERR: the command \"sa\" requires 1, 2, 3 or 4 arguments" << endl;
+        return;
+    }
+
+    vector<uint64_t> inputs;
+    size_t num_vectors = 0;
+    size_t num_lines = 0;
+    switch(m_circuit.load_stimulus_file(args[1], inputs, num_vectors, num_lines)){
+        case 0:
+            break;
+
+        case 1:
+            m_os << "ERR: stimulus file can't be opened" << endl;
+            return;
+
+        case 3:
+            m_os << "ERR: line " << num_lines << " of the stimulus isn't a valid input vector" << endl;
+            return;
+
+        default:
+            m_os << GENERIC_INVALID_COMMAND_MSG << endl;
+            return;
+    }
+
+    switching_activity_report report;
+    if(m_circuit.simulate_switching_activity(inputs, num_vectors, report, num_threads)){
+        m_os << "ERR: some gates in the circuit have their inputs not connected" << endl;
+        return;
+    }
+
+    m_os << "Vectors: " << num_vectors << ", toggles: " << report.total_toggles;
+    m_os << ", per transition: " << report.toggles_per_transition(report.total_toggles) << endl;
+
+    m_os << "Toggles per layer:" << endl;
+    for(const auto& l : report.layer_toggles){
+        if(l.first == 0)
+            m_os << "    Input layer: ";
+        else if(l.first == static_cast<size_t>(-1))
+            m_os << "    Output layer: ";
+        else
+            m_os << "    Layer " << l.first << ": ";
+        m_os << l.second << " (" << report.toggles_per_transition(l.second) << " per transition)" << endl;
+    }
+
+    const string type_str[] = {"BUF", "NOT", "AND", "OR", "XOR", "NND", "NOR", "NXR"};
+    m_os << "Toggles per gate type:" << endl;
+    for(const auto& t : report.type_toggles)
+        m_os << "    " << type_str[static_cast<int>(t.first)] << ": " << t.second << " (" << report.toggles_per_transition(t.second) << " per transition)" << endl;
+
+    if(args.size() == 3){
+        ofstream report_file(args[2]);
+        if(!report_file.is_open()){
+            m_os << "ERR: output file can't be opened" << endl;
+            return;
+        }
+
+        for(const auto& g : report.gate_toggles)
+            report_file << g.first << " " << g.second << " " << report.toggles_per_transition(g.second) << "\n";
+    }
+
+    m_os << VALID_COMMAND_MSG << endl;
+}
+
+//Handle testability analysis
+void console::analyze_testability(const std::vector<std::string>& command_and_args){
+    size_t uid = 0;
+    bool single_gate = false;
+    ofstream output_file;
+
+    switch(command_and_args.size()){
+        case 1:
+            break;
+
+        case 2:
+            if(validate_uint(command_and_args[1], uid, "ERR: the specified uid can't be converted to uint"))
+                return;
+
+            single_gate = true;
+            break;
+
+        case 3:
+            if(command_and_args[1] != "-f"){
+                m_os << "ERR: unrecognised option \"" << command_and_args[1] << "\"" << endl;
+                return;
+            }
+
+            output_file.open(command_and_args[2]);
+            if(!output_file.is_open()){
+                m_os << "ERR: output file can't be opened" << endl;
+                return;
+            }
+            break;
+
+        default:
+            m_os << "ERR: the command \"ta\" requires 0, 1 or 2 arguments" << endl;
+            return;
+            break;
+    }
+
+    map<size_t, gate_testability> results;
+    if(m_circuit.analyze_testability(results)){
+        m_os << "ERR: some gates in the circuit have their inputs not connected" << endl;
+        return;
+    }
+
+    if(single_gate && !results.contains(uid)){
+        m_os << "ERR: there's no gate with the specified uid" << endl;
+        return;
+    }
+
+    ostream& os = (output_file.is_open() ? output_file : m_os);
+    auto print_scoap = [&os](const uint64_t& value){
+        if(value >= SCOAP_INFINITY)
+            os << "inf";
+        else
+            os << value;
+    };
+    auto print_gate = [&](const size_t& gate_uid, const gate_testability& t){
+        os << gate_uid << " ";
+        print_scoap(t.cc0);
+        os << " ";
+        print_scoap(t.cc1);
+        os << " ";
+        print_scoap(t.co);
+        os << " " << t.p1 << " " << t.obs << "\n";
+    };
+
+    os << "uid cc0 cc1 co p1 obs" << "\n";
+    if(single_gate)
+        print_gate(uid, results[uid]);
+    else {
+        for(const auto& r : results)
+            print_gate(r.first, r.second);
+    }
+    os.flush();
+
+    m_os << VALID_COMMAND_MSG << endl;
+}
+
+//Handle the estimation of the signal probabilities by random sampling
+void console::sample_signal_probabilities(const std::vector<std::string>& command_and_args){
+    size_t num_samples = 0;
+    size_t seed = 0;
+    size_t num_threads = 1;
+    ofstream output_file;
+
+    if(command_and_args.size() < 2){
+        m_os << "ERR: the command \"sample\" requires at least 1 argument" << endl;
+        return;
+    }
+
+    if(validate_uint(command_and_args[1], num_samples, "ERR: the specified number of samples can't be converted to uint"))
+        return;
+
+    for(size_t i = 2; i < command_and_args.size(); ++i){
+        const string& option = command_and_args[i];
+
+        if(option != "-s" && option != "-j" && option != "-f"){
+            m_os << "ERR: unrecognised option \"" << option << "\"" << endl;
+            return;
+        }
+
+        if(i + 1 == command_and_args.size()){
+            m_os << "ERR: the option \"" << option << "\" requires 1 argument" << endl;
+            return;
+        }
+
+        const string& arg = command_and_args[++i];
+        if(option == "-s"){
+            if(validate_uint(arg, seed, "ERR: the specified seed can't be converted to uint"))
+                return;
+        }
+        else if(option == "-j"){
+            if(validate_uint(arg, num_threads, "ERR: the specified number of threads can't be converted to uint"))
+                return;
+        }
+        else {
+            output_file.open(arg);
+            if(!output_file.is_open()){
+                m_os << "ERR: output file can't be opened" << endl;
+                return;
+            }
+        }
+    }
+
+    sampling_report report;
+    if(m_circuit.sample_signal_probabilities(num_samples, seed, report, num_threads)){
+        m_os << "ERR: some gates in the circuit have their inputs not connected" << endl;
+        return;
+    }
+
+    double low, high;
+    m_os << "Samples: " << report.num_samples << endl;
+    for(size_t j = 0; j < report.output_ones.size(); ++j){
+        report.confidence_interval(report.output_ones[j], low, high);
+        m_os << "Output " << j << ": " << report.probability(report.output_ones[j]) << " [" << low << ", " << high << "]" << endl;
+    }
+
+    ostream& os = (output_file.is_open() ? output_file : m_os);
+    os << "uid p1 low high" << "\n";
+    for(const auto& g : report.gate_ones){
+        report.confidence_interval(g.second, low, high);
+        os << g.first << " " << report.probability(g.second) << " " << low << " " << high << "\n";
+    }
+    os.flush();
+
+    m_os << VALID_COMMAND_MSG << endl;
+}
+
+//Handle the analysis of the outputs with binary decision diagrams
+void console::build_output_bdds(const std::vector<std::string>& command_and_args){
+    bool reorder = false;
+    string other_filename;
+    string inputs_str;
+    bool compare = false;
+    bool query = false;
+
+    for(size_t i = 1; i < command_and_args.size(); ++i){
+        const string& option = command_and_args[i];
+
+        if(option == "-r")
+            reorder = true;
+        else if((option == "-e" || option == "-q") && i + 1 < command_and_args.size()){
+            if(option == "-e"){
+                compare = true;
+                other_filename = command_and_args[++i];
+            }
+            else {
+                query = true;
+                inputs_str = command_and_args[++i];
+            }
+        }
+        else if(option == "-e" || option == "-q"){
+            m_os << "ERR: the option \"" << option << "\" requires 1 argument" << endl;
+            return;
+        }
+        else {
+            m_os << "ERR: unrecognised option \"" << option << "\"" << endl;
+            return;
+        }
+    }
+
+    if(compare && query){
+        m_os << "ERR: the options \"-e\" and \"-q\" can't be used together" << endl;
+        return;
+    }
+
+    vector<bool> inputs;
+    if(query){
+        if(inputs_str.size() != m_circuit.num_inputs()){
+            m_os << "ERR: the number of specified bits as inputs isn't equal to the number of inputs of the circuit" << endl;
+            return;
+        }
+
+        for(const auto& c : inputs_str){
+            if(c != '0' && c != '1'){
+                m_os << "ERR: invalid character found in argument of command" << endl;
+                return;
+            }
+            inputs.push_back(c == '1');
+        }
+    }
+
+    circuit other(1, 1);
+    if(compare){
+        size_t error_line, error_column;
+        int ret_val;
+        if(is_binary_circuit_file(other_filename))
+            ret_val = other.load_circuit_from_binary_file(other_filename);
+        else if(is_bench_circuit_file(other_filename))
+            ret_val = other.load_circuit_from_bench_file(other_filename, error_line, error_column);
+        else
+            ret_val = other.load_circuit_from_file(other_filename);
+
+        if(ret_val){
+            m_os << "ERR: the circuit to compare can't be loaded from the specified file" << endl;
+            return;
+        }
+
+        if(other.num_inputs() != m_circuit.num_inputs() || other.num_outputs() != m_circuit.num_outputs()){
+            m_os << "ERR: the circuit to compare doesn't have the same number of inputs and outputs" << endl;
+            return;
+        }
+    }
+
+    //Both circuits are built in the same manager, so the outputs are equivalent if and only if they have the same BDD
+    bdd_manager manager(m_circuit.num_inputs());
+    vector<uint32_t> outputs;
+    vector<uint32_t> other_outputs;
+
+    int ret_val_from_fn = m_circuit.build_output_bdds(manager, outputs, reorder);
+    if(ret_val_from_fn == 0 && compare)
+        ret_val_from_fn = other.build_output_bdds(manager, other_outputs, reorder);
+
+    switch(ret_val_from_fn){
+        case 0:
+            break;
+
+        case 1:
+            m_os << "ERR: some gates in the circuit have their inputs not connected" << endl;
+            return;
+            break;
+
+        case 3:
+            m_os << "ERR: the binary decision diagrams of the outputs are too big" << endl;
+            return;
+            break;
+
+        default:
+            m_os << GENERIC_INVALID_COMMAND_MSG << endl;
+            return;
+            break;
+    }
+
+    if(query){
+        for(const auto& out : outputs)
+            m_os << (int)manager.eval(out, inputs);
+        m_os << endl;
+    }
+    else if(compare){
+        size_t num_different = 0;
+        vector<bool> counterexample;
+
+        for(size_t j = 0; j < outputs.size(); ++j){
+            m_os << "Output " << j << ": ";
+            if(outputs[j] == other_outputs[j]){
+                m_os << "equivalent" << endl;
+                continue;
+            }
+
+            ++num_different;
+            manager.pick_sat(manager.bdd_xor(outputs[j], other_outputs[j]), counterexample);
+            m_os << "different, e.g. with inputs ";
+            for(const auto& b : counterexample)
+                m_os << (int)b;
+            m_os << endl;
+        }
+
+        m_os << (num_different == 0 ? "The circuits are equivalent" : "The circuits aren't equivalent") << endl;
+    }
+    else {
+        const ios_base::fmtflags flags = m_os.flags();
+        m_os << fixed << setprecision(0);
+
+        for(size_t j = 0; j < outputs.size(); ++j)
+            m_os << "Output " << j << ": " << manager.size({outputs[j]}) << " nodes, " << manager.sat_count(outputs[j]) << " minterms" << endl;
+        m_os << "Total nodes: " << manager.size(outputs) << endl;
+
+        m_os.flags(flags);
+        if(reorder){
+            m_os << "Variable order:";
+            for(size_t l = 0; l < manager.num_vars(); ++l)
+                m_os << " " << manager.var_at_level(l);
+            m_os << endl;
+        }
+    }
+
+    m_os << VALID_COMMAND_MSG << endl;
+}
+
+//Handle circuit optimization
+void console::optimize(const std::vector<std::string>& command_and_args){
+    ofstream output_file;
+
+    switch(command_and_args.size()){
+        case 1:
+            break;
+
+        case 3:
+            if(command_and_args[1] != "-f"){
+                m_os << "ERR: unrecognised option \"" << command_and_args[1] << "\"" << endl;
+                return;
+            }
+
+            output_file.open(command_and_args[2]);
+            if(!output_file.is_open()){
+                m_os << "ERR: output file can't be opened" << endl;
+                return;
+            }
+            break;
+
+        default:
+            m_os << "ERR: the command \"optimize\" requires 0 or 2 arguments" << endl;
+            return;
+            break;
+    }
+
+    optimization_report report;
+    if(m_circuit.optimize(report)){
+        m_os << "ERR: some gates in the circuit have their inputs not connected" << endl;
+        return;
+    }
+
+    m_os << "Gates: " << report.num_gates_before << " -> " << report.num_gates_after << ", removed: " << report.num_removed();
+    m_os << " (constant: " << report.constant_gates.size() << ", wires: " << report.wire_gates.size() << ", dead: " << report.dead_gates.size() << ")" << endl;
+
+    if(output_file.is_open()){
+        for(const auto& uid : report.constant_gates)
+            output_file << uid << " constant" << "\n";
+        for(const auto& uid : report.wire_gates)
+            output_file << uid << " wire" << "\n";
+        for(const auto& uid : report.dead_gates)
+            output_file << uid << " dead" << "\n";
+    }
+
+    m_os << VALID_COMMAND_MSG << endl;
+}
+
+//Handle the sweeping of the equivalent gates
+void console::sweep_equivalent_gates(const std::vector<std::string>& command_and_args){
+    size_t seed = 0;
+    ofstream output_file;
+
+    for(size_t i = 1; i < command_and_args.size(); ++i){
+        const string& option = command_and_args[i];
+
+        if(option != "-s" && option != "-f"){
+            m_os << "ERR: unrecognised option \"" << option << "\"" << endl;
+            return;
+        }
+
+        if(i + 1 == command_and_args.size()){
+            m_os << "ERR: the option \"" << option << "\" requires 1 argument" << endl;
+            return;
+        }
+
+        const string& arg = command_and_args[++i];
+        if(option == "-s"){
+            if(validate_uint(arg, seed, "ERR: the specified seed can't be converted to uint"))
+                return;
+        }
+        else {
+            output_file.open(arg);
+            if(!output_file.is_open()){
+                m_os << "ERR: output file can't be opened" << endl;
+                return;
+            }
+        }
+    }
+
+    sweep_report report;
+    if(m_circuit.sweep_equivalent_gates(seed, report)){
+        m_os << "ERR: some gates in the circuit have their inputs not connected" << endl;
+        return;
+    }
+
+    m_os << "Candidate classes: " << report.num_candidate_classes << ", proven: " << report.num_proven << ", refuted: " << report.num_refuted;
+    m_os << ", unresolved: " << report.num_unresolved << endl;
+    m_os << "Gates: " << report.num_gates_before << " -> " << report.num_gates_after << ", removed: " << report.num_gates_before - report.num_gates_after;
+    m_os << " (merged: " << report.merged_gates.size() << ", dead: " << report.dead_gates.size() << ")" << endl;
+
+    if(output_file.is_open()){
+        for(const auto& g : report.merged_gates)
+            output_file << g.uid << (g.inverted ? " inverse " : " equivalent ") << g.uid_equivalent << "\n";
+        for(const auto& uid : report.dead_gates)
+            output_file << uid << " dead" << "\n";
+    }
+
+    m_os << VALID_COMMAND_MSG << endl;
+}
+
+//Handle the conversion of the circuit to an and-inverter graph
+void console::convert_to_aig(const std::vector<std::string>& command_and_args){
+    bool rewrite = false;
+
+    switch(command_and_args.size()){
+        case 1:
+            break;
+
+        case 2:
+            if(command_and_args[1] != "-r"){
+                m_os << "ERR: unrecognised option \"" << command_and_args[1] << "\"" << endl;
+                return;
+            }
+            rewrite = true;
+            break;
+
+        default:
+            m_os << "ERR: the command \"aig\" requires 0 or 1 arguments" << endl;
+            return;
+            break;
+    }
+
+    const size_t num_gates_before = m_circuit.num_gates();
+
+    aig graph(0);
+    if(m_circuit.to_aig(graph)){
+        m_os << "ERR: some gates in the circuit have their inputs not connected" << endl;
+        return;
+    }
+
+    vector<uint32_t> node_levels;
+    m_os << "AND nodes: " << graph.num_ands() << ", levels: " << graph.levels(node_levels) << endl;
+
+    if(rewrite){
+        graph.optimize();
+        m_os << "After rewriting, AND nodes: " << graph.num_ands() << ", levels: " << graph.levels(node_levels) << endl;
+    }
+
+    m_circuit.from_aig(graph);
+    m_os << "Gates: " << num_gates_before << " -> " << m_circuit.num_gates() << endl;
+
+    m_os << VALID_COMMAND_MSG << endl;
+}
+
 //Handle truth table generation
 void console::gen_truth_table(const std::vector<std::string>& command_and_args){
-    if(command_and_args.size() == 1){
-        if(m_circuit.gen_truth_table(m_os))
+    size_t num_threads = 1;
+    bool gray_code = false;
+    string packed_filename;
+
+    for(size_t arg = 1; arg < command_and_args.size(); ++arg){
+        const string& option = command_and_args[arg];
+
+        if(option == "-g")
+            gray_code = true;
+        else if(option == "-j" && arg + 1 < command_and_args.size()){
+            if(validate_uint(command_and_args[++arg], num_threads, "ERR: the specified number of threads can't be converted to uint"))
+                return;
+        }
+        else if(option == "-b" && arg + 1 < command_and_args.size())
+            packed_filename = command_and_args[++arg];
+        else{
+            m_os << "ERR: unrecognised option \"" << option << "\"" << endl;
+            return;
+        }
+    }
+
+    if(gray_code && (num_threads != 1 || !packed_filename.empty())){
+        m_os << "ERR: the option \"-g\" can't be used together with the other options" << endl;
+        return;
+    }
+
+    int ret_val_from_fn = -10;
+    if(!packed_filename.empty()){
+        ofstream packed_file(packed_filename, ios::binary);
+        if(!packed_file.is_open()){
+            m_os << "ERR: output file can't be opened" << endl;
+            return;
+        }
+
+        ret_val_from_fn = m_circuit.gen_truth_table_packed(packed_file, num_threads);
+    }
+    else if(gray_code)
+        ret_val_from_fn = m_circuit.gen_truth_table_gray(m_os);
+    else
+        ret_val_from_fn = m_circuit.gen_truth_table(m_os, num_threads);
+
+    switch(ret_val_from_fn){
+        case 0:
+            m_os << VALID_COMMAND_MSG << endl;
+            break;
+
+        case 1:
             m_os << "ERR: some gates in the circuit have their inputs not connected" << endl;
+            break;
+
+        case 2:
+            m_os << "ERR: the circuit has too many inputs to enumerate all their combinations" << endl;
+            break;
+
+        case 3:
+            m_os << "ERR: the truth table couldn't be written completely in the output file" << endl;
+            break;
+
+        default:
+            m_os << GENERIC_INVALID_COMMAND_MSG << endl;
+            break;
+    }
+}
+
+//Handle queries on a truth table written in the binary format
+void console::query_truth_table(const std::vector<std::string>& command_and_args){
+    if(command_and_args.size() != 2 && command_and_args.size() != 3){
+        m_os << "ERR: the command \"qtt\" requires 1 or 2 arguments" << endl;
+        return;
+    }
+
+    packed_truth_table table;
+    switch(table.open(command_and_args[1])){
+        case 0:
+            break;
+
+        case 1:
+            m_os << "ERR: input file can't be opened" << endl;
+            return;
+
+        case 2:
+            m_os << "ERR: the file isn't a truth table in the binary format" << endl;
+            return;
+
+        case 3:
+            m_os << "ERR: the truth table has been written by an unsupported version of the format" << endl;
+            return;
+
+        case 4:
+            m_os << "ERR: the truth table is truncated or corrupted" << endl;
+            return;
+
+        default:
+            m_os << GENERIC_INVALID_COMMAND_MSG << endl;
+            return;
+    }
+
+    if(command_and_args.size() == 2){
+        m_os << "Inputs: " << table.num_inputs() << ", outputs: " << table.num_outputs() << ", rows: " << table.num_rows() << endl;
+        for(size_t j = 0; j < table.num_outputs(); ++j)
+            m_os << "Output " << j << " is 1 in " << table.count_ones(j) << " rows" << endl;
+    }
+    else{
+        const string inputs_str = command_and_args[2];
+        if(inputs_str.size() != table.num_inputs()){
+            m_os << "ERR: the number of specified bits as inputs isn't equal to the number of inputs of the truth table" << endl;
+            return;
+        }
+
+        uint64_t row = 0;
+        for(size_t i = 0; i < inputs_str.size(); ++i){
+            if(inputs_str[i] != '0' && inputs_str[i] != '1'){
+                m_os << "ERR: invalid character found in argument of command" << endl;
+                return;
+            }
+
+            row |= uint64_t(inputs_str[i] - '0') << i;
+        }
+
+        for(const auto& out : table.read_outputs(row))
+            m_os << (int)out;
+        m_os << endl;
+    }
+
+    m_os << VALID_COMMAND_MSG << endl;
+}
+
+//Handle the selection of the kernel used by the bit-parallel simulation engine
+void console::set_sim_kernel(const std::vector<std::string>& command_and_args){
+    const vector<sim_kernel> kernels = {sim_kernel::automatic, sim_kernel::scalar, sim_kernel::sse2, sim_kernel::avx2, sim_kernel::avx512};
+
+    if(command_and_args.size() == 1){
+        m_os << "Kernel in use : " << kernel_to_str(m_circuit.get_sim_kernel());
+        if(m_circuit.get_sim_kernel() == sim_kernel::automatic)
+            m_os << " (" << kernel_to_str(best_kernel()) << ")";
+        m_os << endl;
+
+        m_os << "Supported     :";
+        for(const auto& k : kernels){
+            if(k != sim_kernel::automatic && kernel_supported(k))
+                m_os << " " << kernel_to_str(k);
+        }
+        m_os << endl;
+
+        m_os << VALID_COMMAND_MSG << endl;
+    }
+    else if(command_and_args.size() == 2){
+        string kernel_str = command_and_args[1];
+        transform(kernel_str.begin(), kernel_str.end(), kernel_str.begin(), [](const unsigned char c){return tolower(c);});
+
+        auto it_kernel = find_if(kernels.begin(), kernels.end(), [&](const sim_kernel& k){return kernel_to_str(k) == kernel_str;});
+        if(it_kernel == kernels.end()){
+            m_os << "ERR: unrecognised kernel" << endl;
+            return;
+        }
+
+        if(m_circuit.set_sim_kernel(*it_kernel) == 0)
+            m_os << VALID_COMMAND_MSG << endl;
         else
+            m_os << "ERR: the specified kernel isn't supported by this CPU" << endl;
+    }
+    else{
+        m_os << "ERR: the command \"sk\" requires 0 or 1 argument" << endl;
+    }
+}
+
+//Handle the compilation of the circuit to native code
+void console::compile_native(const std::vector<std::string>& command_and_args){
+    bool use_native = true;
+
+    switch(command_and_args.size()){
+        case 1:
+            break;
+
+        case 2:
+            if(validate_bool(command_and_args[1], use_native, "ERR: the specified flag can't be converted to int and then to bool"))
+                return;
+            break;
+
+        default:
+            m_os << "ERR: the command \"nc\" requires 0 or 1 argument" << endl;
+            return;
+            break;
+    }
+
+    if(!use_native){
+        m_circuit.drop_native();
+        m_os << VALID_COMMAND_MSG << endl;
+        return;
+    }
+
+    switch(m_circuit.compile_native()){
+        case 0:
             m_os << VALID_COMMAND_MSG << endl;
+            break;
+
+        case 1:
+            m_os << "ERR: some gates in the circuit have their inputs not connected" << endl;
+            break;
+
+        case 2:
+            m_os << "ERR: no working compiler found, the interpreter will be used" << endl;
+            break;
+
+        case 3:
+            m_os << "ERR: the native code can't be loaded, the interpreter will be used" << endl;
+            break;
+
+        default:
+            m_os << GENERIC_INVALID_COMMAND_MSG << endl;
+            break;
+    }
+}
+
+//Handle the switch between the complete and the event-driven simulation
+void console::set_event_driven(const std::vector<std::string>& command_and_args){
+    if(command_and_args.size() == 1){
+        m_os << "Event-driven simulation : " << (m_circuit.is_event_driven() ? "on" : "off") << endl;
+        m_os << VALID_COMMAND_MSG << endl;
+    }
+    else if(command_and_args.size() == 2){
+        bool event_driven;
+        if(validate_bool(command_and_args[1], event_driven, "ERR: the specified flag can't be converted to int and then to bool"))
+            return;
+
+        m_circuit.set_event_driven(event_driven);
+        m_os << VALID_COMMAND_MSG << endl;
     }
     else{
-        m_os << "ERR: the command \"gtt\" requires no arguments" << endl;
+        m_os << "ERR: the command \"ed\" requires 0 or 1 argument" << endl;
     }
 }
 
@@ -1028,8 +1938,15 @@ void console::list_unconnected(const std::vector<std::string>& command_and_args)
 void console::save_circuit(const std::vector<std::string>& command_and_args){
     if(command_and_args.size() == 2){
         const string filename = command_and_args[1];
+        if(is_bench_circuit_file(filename)){
+            m_os << "ERR: circuits can't be saved in the .bench format" << endl;
+            return;
+        }
 
-        if(m_circuit.save_circuit_to_file(filename) == 0)
+        const int ret_val = is_binary_circuit_file(filename) ? m_circuit.save_circuit_to_binary_file(filename) :
+                                                               m_circuit.save_circuit_to_file(filename);
+
+        if(ret_val == 0)
             m_os << VALID_COMMAND_MSG << endl;
         else
             m_os << "ERR: output file can't be opened" << endl;
@@ -1044,7 +1961,84 @@ void console::load_circuit(const std::vector<std::string>& command_and_args){
     if(command_and_args.size() == 2){
         const string filename = command_and_args[1];
 
-        switch(m_circuit.load_circuit_from_file(filename)){
+        if(is_binary_circuit_file(filename)){
+            switch(m_circuit.load_circuit_from_binary_file(filename)){
+                case 0:
+                    m_os << VALID_COMMAND_MSG << endl;
+                    break;
+
+                case 1:
+                    m_os << "ERR: input file can't be opened" << endl;
+                    break;
+
+                case 2:
+                    m_os << "ERR: the file isn't a circuit in the binary format" << endl;
+                    break;
+
+                case 3:
+                    m_os << "ERR: the file has been saved by an unsupported version of the binary format, or on a different machine" << endl;
+                    break;
+
+                case 4:
+                    m_os << "ERR: the file is truncated or corrupted" << endl;
+                    break;
+
+                case 5:
+                    m_os << "ERR: the circuit in the file is inconsistent" << endl;
+                    break;
+
+                default:
+                    m_os << GENERIC_INVALID_COMMAND_MSG << endl;
+                    break;
+            }
+            return;
+        }
+
+        size_t error_line = 0, error_column = 0;
+        if(is_bench_circuit_file(filename)){
+            const int ret_val = m_circuit.load_circuit_from_bench_file(filename, error_line, error_column);
+
+            if(ret_val != 0 && ret_val != 1)
+                m_os << "ERR: line " << error_line << ", column " << error_column << ": ";
+
+            switch(ret_val){
+                case 0:
+                    m_os << VALID_COMMAND_MSG << endl;
+                    break;
+
+                case 1:
+                    m_os << "ERR: input file can't be opened" << endl;
+                    break;
+
+                case 4:
+                    m_os << "badly formatted line" << endl;
+                    break;
+
+                case 40:
+                    m_os << "unsupported gate type" << endl;
+                    break;
+
+                case 5:
+                    m_os << "the net is defined twice, or used but never defined" << endl;
+                    break;
+
+                case 50:
+                    m_os << "the gate is part of a combinational loop" << endl;
+                    break;
+
+                default:
+                    m_os << GENERIC_INVALID_COMMAND_MSG << endl;
+                    break;
+            }
+            return;
+        }
+
+        const int ret_val = m_circuit.load_circuit_from_file(filename, error_line, error_column);
+
+        if(ret_val != 0 && ret_val != 1)
+            m_os << "ERR: line " << error_line << ", column " << error_column << ": ";
+
+        switch(ret_val){
             case 0:
                 m_os << VALID_COMMAND_MSG << endl;
                 break;
@@ -1054,31 +2048,31 @@ void console::load_circuit(const std::vector<std::string>& command_and_args){
                 break;
 
             case 2:
-                m_os << "ERR: can't read number of inputs from file" << endl;
+                m_os << "can't read number of inputs from file" << endl;
                 break;
 
             case 20:
-                m_os << "ERR: badly formatted number of inputs" << endl;
+                m_os << "badly formatted number of inputs" << endl;
                 break;
 
             case 3:
-                m_os << "ERR: can't read number of outputs from filr" << endl;
+                m_os << "can't read number of outputs from file" << endl;
                 break;
 
             case 30:
-                m_os << "ERR: badly formatted number of outputs" << endl;
+                m_os << "badly formatted number of outputs" << endl;
                 break;
 
             case 4:
-                m_os << "ERR: file contains a non recognized line type" << endl;
+                m_os << "badly formatted line, or non recognized line type" << endl;
                 break;
 
             case 40:
-                m_os << "ERR: line types are out of order, they must go Ls, Gs and then Cs" << endl;
+                m_os << "line types are out of order, they must go Ls, Gs and then Cs" << endl;
                 break;
 
             case 5:
-                m_os << "ERR: the information specified in one of the lines of the file is invalid" << endl;
+                m_os << "the layer or gate specified doesn't exist or already exists, or the connection goes backwards" << endl;
                 break;
 
             default:
@@ -1144,8 +2138,34 @@ void console::execute_command(const string& user_input){
         read_outputs(command_and_args);
     else if(command_str == "sc")
         simulate_circuit(command_and_args);
+    else if(command_str == "ssf")
+        simulate_stimulus_file(command_and_args);
+    else if(command_str == "fs")
+        simulate_faults(command_and_args);
+    else if(command_str == "sa")
+        simulate_switching_activity(command_and_args);
+    else if(command_str == "ta")
+        analyze_testability(command_and_args);
+    else if(command_str == "sample")
+        sample_signal_probabilities(command_and_args);
+    else if(command_str == "bdd")
+        build_output_bdds(command_and_args);
+    else if(command_str == "optimize")
+        optimize(command_and_args);
+    else if(command_str == "sweep")
+        sweep_equivalent_gates(command_and_args);
+    else if(command_str == "aig")
+        convert_to_aig(command_and_args);
     else if(command_str == "gtt")
         gen_truth_table(command_and_args);
+    else if(command_str == "qtt")
+        query_truth_table(command_and_args);
+    else if(command_str == "sk")
+        set_sim_kernel(command_and_args);
+    else if(command_str == "nc")
+        compile_native(command_and_args);
+    else if(command_str == "ed")
+        set_event_driven(command_and_args);
     else if(command_str == "pc")
         print_circuit(command_and_args);
     else if(command_str == "lu")
@@ -18,6 +18,8 @@ class console{
         std::vector<std::string> split_string_in_substrings(std::string input, const std::string& delimiters);
         int validate_uint(const std::string& input_str, size_t& ouput_uint, const std::string& error_msg);
         int validate_bool(const std::string& input_str, bool& ouput_bool, const std::string& error_msg);
+        bool is_binary_circuit_file(const std::string& filename);
+        bool is_bench_circuit_file(const std::string& filename);
 
         void print_help(const std::vector<std::string>& command_and_args);
         void set_num_io(const std::vector<std::string>& command_and_args);
@@ -39,7 +41,20 @@ class console{
         void set_inputs(const std::vector<std::string>& command_and_args);
         void read_outputs(const std::vector<std::string>& command_and_args);
         void simulate_circuit(const std::vector<std::string>& command_and_args);
+        void simulate_stimulus_file(const std::vector<std::string>& command_and_args);
+        void simulate_faults(const std::vector<std::string>& command_and_args);
+        void simulate_switching_activity(const std::vector<std::string>& command_and_args);
+        void analyze_testability(const std::vector<std::string>& command_and_args);
+        void sample_signal_probabilities(const std::vector<std::string>& command_and_args);
+        void build_output_bdds(const std::vector<std::string>& command_and_args);
+        void optimize(const std::vector<std::string>& command_and_args);
+        void sweep_equivalent_gates(const std::vector<std::string>& command_and_args);
+        void convert_to_aig(const std::vector<std::string>& command_and_args);
         void gen_truth_table(const std::vector<std::string>& command_and_args);
+        void query_truth_table(const std::vector<std::string>& command_and_args);
+        void set_sim_kernel(const std::vector<std::string>& command_and_args);
+        void compile_native(const std::vector<std::string>& command_and_args);
+        void set_event_driven(const std::vector<std::string>& command_and_args);
         void print_circuit(const std::vector<std::string>& command_and_args);
         void list_unconnected(const std::vector<std::string>& command_and_args);
         void save_circuit(const std::vector<std::string>& command_and_args);
@@ -0,0 +1,36 @@
+#ifndef FAULTS_HPP
+#define FAULTS_HPP
+
+#include <vector>
+#include <cstddef>
+
+#define FAULT_NOT_DETECTED static_cast<size_t>(-1)
+
+//----------------------------------------------------------------------------------------------------------------------
+//Stuck-at faults, on the output of a gate or on one of its connected inputs. A fault on an input only affects the gate
+//owning that input, while a fault on an output affects all the gates connected to it
+enum class fault_site{output, input0, input1};
+
+struct fault{
+    size_t uid_gate;
+    fault_site site;
+    bool stuck_at;
+
+    fault(const size_t& uid, const fault_site& s, const bool& value) :
+        uid_gate(uid),
+        site(s),
+        stuck_at(value)
+    {}
+};
+
+//Result of a fault simulation: for every fault, the index of the first input vector that detects it, which is
+//FAULT_NOT_DETECTED if none of them does
+struct fault_sim_report{
+    std::vector<fault> faults;
+    std::vector<size_t> detecting_vectors;
+    size_t num_detected = 0;
+
+    double coverage() const {return faults.empty() ? 1.0 : double(num_detected) / faults.size();}
+};
+
+#endif
@@ -4,88 +4,68 @@
 #include <vector>
 #include <iostream>
 #include <string>
+#include <cstdint>
+
+#define NO_GATE UINT32_MAX                          //Index read by the inputs of a gate that aren't connected
 
 //----------------------------------------------------------------------------------------------------------------------
 //Basic struct of a logic gate
-enum class status{to_update, updated};
-enum class gate_type{buffer, not_gate, and_gate, or_gate, xor_gate, nand_gate, nor_gate, nxor_gate};
+//It only describes the structure of the circuit, the values of the signals are stored in the compiled form of the
+//circuit (see gate_op below). The circuit keeps all its gates in a single array, and every gate references the gates
+//connected to its inputs by their index in it, so that the records stay small and can be moved or copied freely
+enum class gate_type : uint8_t{buffer, not_gate, and_gate, or_gate, xor_gate, nand_gate, nor_gate, nxor_gate};
 
 struct gate{
+    uint32_t in0;                                   //Index of the gate connected to input 0, NO_GATE if unconnected
+    uint32_t in1;
     gate_type type;
-    size_t uid_gate;
-    status gate_status;
-
-    bool input_0;
-    gate* ptr_gate_in0;
-    bool take_inv_output_in_in0;
-    
-    bool input_1;
-    gate* ptr_gate_in1;
-    bool take_inv_output_in_in1;
-
-    bool output;
-    bool inv_output;
+    bool inv_in0;                                   //Set if input 0 takes the inverted output of its gate
+    bool inv_in1;
 
-    gate(const gate_type& t = gate_type::buffer, const size_t& uid = 0) : 
+    gate(const gate_type& t = gate_type::buffer) :
+        in0(NO_GATE),
+        in1(NO_GATE),
         type(t),
-        uid_gate(uid),
-        gate_status(status::to_update),
-        input_0(false),
-        ptr_gate_in0(nullptr),
-        take_inv_output_in_in0(false),
-        input_1(false),
-        ptr_gate_in1(nullptr),
-        take_inv_output_in_in1(false),
-        output(false),
-        inv_output(true)
-    {} 
-
-    int calc_output(){
-        if(gate_status == status::updated)
-            return 0;
+        inv_in0(false),
+        inv_in1(false)
+    {}
+};
 
-        if(type == gate_type::buffer || type == gate_type::not_gate){
-            if(ptr_gate_in0 == nullptr && ptr_gate_in1 == nullptr)
-                return 1;   
-        }
-        else if(ptr_gate_in0 == nullptr || ptr_gate_in1 == nullptr){
-            return 1;
-        }
+//----------------------------------------------------------------------------------------------------------------------
+//Compiled form of a gate, used by the simulation engines.
+//Gates are referenced by the index of the net they drive instead of by pointer, and every net carries one bit per
+//simulated input vector. Buffers and NOT gates only use in0 (if both their inputs are connected they're turned into OR
+//and NOR gates respectively), in1 is then set equal to in0 so that it can always be read safely.
+struct gate_op{
+    gate_type type;
+    bool inv_in0;
+    bool inv_in1;
+    uint32_t net_in0;
+    uint32_t net_in1;
+    uint32_t net_out;
 
-        if(ptr_gate_in0 != nullptr)
-            input_0 = (take_inv_output_in_in0 ? ptr_gate_in0->inv_output : ptr_gate_in0->output);
-        if(ptr_gate_in1 != nullptr)
-            input_1 = (take_inv_output_in_in1 ? ptr_gate_in1->inv_output : ptr_gate_in1->output);
+    uint64_t eval(uint64_t in0, uint64_t in1) const {
+        in0 ^= (inv_in0 ? ~uint64_t(0) : 0);
+        in1 ^= (inv_in1 ? ~uint64_t(0) : 0);
 
         switch(type){
             case gate_type::buffer:
-                output = (ptr_gate_in0 != nullptr && input_0) || (ptr_gate_in1 != nullptr && input_1);
-                break;
+                return in0;
             case gate_type::not_gate:
-                output = !((ptr_gate_in0 != nullptr && input_0) || (ptr_gate_in1 != nullptr && input_1));
-                break;
+                return ~in0;
             case gate_type::and_gate:
-                output = input_0 && input_1;
-                break;
+                return in0 & in1;
             case gate_type::or_gate:
-                output = input_0 || input_1;
-                break;
+                return in0 | in1;
             case gate_type::xor_gate:
-                output = input_0 ^ input_1;
-                break;
-             case gate_type::nand_gate:
-                output = !(input_0 && input_1);
-                break;
+                return in0 ^ in1;
+            case gate_type::nand_gate:
+                return ~(in0 & in1);
             case gate_type::nor_gate:
-                output = !(input_0 || input_1);
-                break;
+                return ~(in0 | in1);
             case gate_type::nxor_gate:
-                output = !(input_0 ^ input_1);
-                break;
+                return ~(in0 ^ in1);
         }
-        
-        inv_output = !output;
-        gate_status = status::updated;
 
         return 0;
     }
@@ -32,7 +32,20 @@ The commands recognized by this simulator are the following:
 - si    -> set circuit inputs
 - ro    -> read circuit outputs
 - sc    -> simulate circuit
+- ssf   -> simulate the input vectors of a stimulus file
+- fs    -> simulate the stuck-at faults of the circuit over a set of test vectors
+- sa    -> count the toggles of the gates over a stream of input vectors, for power estimation
+- ta    -> analyze the testability of the gates, without simulating the circuit
+- sample -> estimate the probability of the outputs and gates being 1, with random inputs
+- bdd   -> build the binary decision diagrams of the outputs, to count, query or compare them
+- optimize -> remove the constant, redundant and dead gates of the circuit
+- sweep -> merge the gates with the same output as another gate, or its inverse
+- aig   -> convert the circuit to an and-inverter graph, optionally minimized by rewriting
 - gtt   -> generate the truth table
+- qtt   -> query a truth table saved in the binary format
+- sk    -> select the kernel of the bit-parallel simulation engine
+- nc    -> compile the circuit to native code
+- ed    -> enable or disable the event-driven simulation
 - pc    -> print circuit
 - lu    -> list unconnected gates
 - vc    -> saves the circuit to file
@@ -283,22 +296,296 @@ This command simulates the propagation of the signals in the circuit according t
 Syntaxes:
 1) "sc"
 2) "sc <in0 0/1><in1 0/1><in2 0/1>..."
+3) "sc -j <num_threads>"
+4) "sc <in0 0/1><in1 0/1><in2 0/1>... -j <num_threads>"
 In syntax 2 the string "sc" is followed by a space and then a series of 1s and 0s, without spaces in between.
 Example: suppose the circuit has 7 inputs -> "sc 1010101".
 With this last syntax, the inputs are set and then the circuit is simulated.
+Syntaxes 3 and 4 are the same as 1 and 2, but the layers of the circuit with many gates are split between
+"num_threads" threads, which is useful only for very wide circuits. Smaller layers are always simulated
+by a single thread. No more threads are used than the processor can run at once, and the threads are
+started only once and then kept for the next simulations.
 
 NOTE: to view the output of the circuit, to see how it reacted to the inputs, use the command "ro".)foobar";
 
+const std::string ssf_help =
+R"foobar("ssf" command.
+This command simulates all the input vectors written in a stimulus file, one after the other, and
+prints the corresponding outputs.
+
+Syntaxes:
+1) "ssf <stimulus file>"
+2) "ssf <stimulus file> <output file>"
+The stimulus file contains an input vector on each line, written like the argument of "si".
+Empty lines and lines starting with '#' are skipped. If the stimulus file is "-", the input vectors
+are read from the standard input.
+Example: suppose the circuit has 4 inputs ->
+0000
+# comment
+1010
+For every input vector a line with the outputs is printed, like "ro" does. With syntax 1 these lines
+are printed on the screen, with syntax 2 they're written in the output file.
+The input vectors are simulated in batches by the bit-parallel simulation engine, so this is much
+faster than using "sc" for every vector. The values of the inputs and outputs of the circuit, the ones
+set by "si" and read by "ro", aren't affected.)foobar";
+
+const std::string fs_help =
+R"foobar("fs" command.
+This command simulates all the single stuck-at faults of the circuit over a set of test vectors, to find
+which of them are detected by the vectors, i.e. make at least an output differ from the fault-free circuit.
+The faults are stuck-at-0 and stuck-at-1 on the output of every gate (except for the constant inputs 0
+and 1) and on every connected input of every gate.
+
+Syntaxes:
+1) "fs <stimulus file>"
+2) "fs <stimulus file> <report file>"
+3) "fs <stimulus file> -j <num_threads>"
+4) "fs <stimulus file> <report file> -j <num_threads>"
+The test vectors are read from the stimulus file, written like for "ssf".
+The number of faults, the number of detected faults and the fault coverage are printed on the screen.
+With syntaxes 2 and 4 the report file lists every fault on a line, with the syntax
+<gate uid> <out/in0/in1> <sa0/sa1> <vector>
+where <vector> is the index of the first test vector detecting the fault (starting from 0, and not
+counting empty lines and comments), or "-" if the fault isn't detected.
+The test vectors are simulated many at a time, and every fault is dropped as soon as it's detected.
+With syntaxes 3 and 4, the faults are split between "num_threads" threads, at most as many as the
+processor can run at once.)foobar";
+
+const std::string sa_help =
+R"foobar("sa" command.
+This command simulates a stream of input vectors and counts how many times the output of every gate
+toggles between two consecutive vectors. Since the dynamic power dissipated by a gate is roughly
+proportional to how often its output switches, this gives an estimate of where the power goes.
+
+Syntaxes:
+1) "sa <stimulus file>"
+2) "sa <stimulus file> <report file>"
+3) "sa <stimulus file> -j <num_threads>"
+4) "sa <stimulus file> <report file> -j <num_threads>"
+The input vectors are read in order from the stimulus file, written like for "ssf".
+The total number of toggles is printed on the screen, followed by the totals of every layer and of
+every type of gate, each with the average number of toggles per transition between two vectors.
+With syntaxes 2 and 4 the report file lists every gate on a line, with the syntax
+<gate uid> <toggles> <toggles per transition>
+The vectors are simulated many at a time by the bit-parallel simulation engine. With syntaxes 3 and
+4, the stream is split between "num_threads" threads, at most as many as the processor can run at once.)foobar";
+
+const std::string ta_help =
+R"foobar("ta" command.
+This command computes some testability measures of the output of every gate, with a single pass over
+the circuit from the inputs to the outputs and a single pass back, without simulating any vector.
+
+Syntaxes:
+1) "ta"
+2) "ta <gate uid>"
+3) "ta -f <filename>"
+With syntax 1 the measures of all the gates are printed on the screen, with syntax 2 only the measures
+of the specified gate, and with syntax 3 the measures of all the gates are written in the specified file.
+Every gate is printed on a line, with the syntax
+<gate uid> <cc0> <cc1> <co> <p1> <obs>
+- cc0 and cc1 are the SCOAP controllabilities to 0 and 1: roughly, the number of gates that have to be
+  set to put the output of the gate at 0 or 1
+- co is the SCOAP observability: roughly, the number of gates that have to be set to propagate the
+  output of the gate to an output of the circuit
+- p1 is the probability of the output of the gate being 1, with uniformly random inputs
+- obs is the probability of the output of the gate being propagated to an output of the circuit
+The SCOAP measures of values that can't be set or observed at all are printed as "inf".
+The probabilities are computed assuming that all the signals in the circuit are independent, which
+isn't true when signals reconverge, so they're estimates: exact for circuits without reconvergence.)foobar";
+
+const std::string sample_help =
+R"foobar("sample" command.
+This command simulates the circuit over uniformly random input vectors, to estimate the probability of
+every output, and of the output of every gate, being 1. It's meant for circuits with too many inputs to
+generate their truth table.
+
+Syntax: "sample <num_samples> [-s <seed>] [-f <filename>] [-j <num_threads>]"
+The number of samples is the number of random input vectors simulated.
+The estimated probability of every output is printed on the screen, followed by its 95% confidence
+interval, with the syntax
+Output <index>: <p1> [<low>, <high>]
+Then every gate is printed on a line, with the syntax
+<gate uid> <p1> <low> <high>
+on the screen, or in the specified file if "-f" is used.
+The random vectors are generated 64 at a time by a xorshift generator, and simulated in batches by the
+bit-parallel simulation engine. They only depend on the seed (0 if not specified), so the same seed
+gives the same results, whatever the number of threads. With "-j", the batches are split between
+"num_threads" threads, at most as many as the processor can run at once.
+The inputs and outputs of the circuit, the ones set by "si" and read by "ro", aren't affected.)foobar";
+
+const std::string bdd_help =
+R"foobar("bdd" command.
+This command builds the reduced ordered binary decision diagrams (BDDs) of the outputs of the circuit,
+canonical graphs of their boolean functions where every variable is an input of the circuit.
+
+Syntaxes:
+1) "bdd"
+2) "bdd -q <inputs>"
+3) "bdd -e <filename>"
+Any of them can be followed by "-r".
+With syntax 1, the number of nodes of the BDD of every output and the number of combinations of the
+inputs for which the output is 1 are printed on the screen, followed by the total number of nodes
+(the BDDs of the outputs share their common nodes).
+With syntax 2 the outputs are computed from the BDDs for the specified inputs, written like for "si",
+and printed like by "ro". The inputs and outputs of the circuit aren't affected.
+With syntax 3 the circuit is compared with the one saved in the specified file, which must have the same
+number of inputs and outputs: for every output, it's printed if it's equivalent in both circuits, i.e. it's
+the same function of the inputs, or a combination of the inputs for which the two circuits differ.
+With "-r" the order of the variables is optimized by sifting while building the BDDs, which can make
+them much smaller, and with syntax 1 the final order (from the top of the BDDs) is printed too.
+NOTE: the size of the BDDs can grow exponentially with the number of inputs for some circuits (e.g.
+multipliers), so this command may run out of memory, in which case an error is printed.)foobar";
+
+const std::string optimize_help =
+R"foobar("optimize" command.
+This command simplifies the circuit, without changing the function of its outputs, by removing:
+- the gates whose output is constant, because some of their inputs are connected to the constant gates
+  0 and 1 of the input layer (e.g. an AND gate with an input at 0, or an OR gate with an input at 1), or
+  because of their own connections (e.g. an XOR gate with both inputs connected to the same gate)
+- the gates whose output is equal to one of their inputs, or to its inverse (e.g. buffers, NOT gates,
+  or an AND gate with an input at 1): the gates they were connected to get connected directly to that
+  input, taking its inverted output if needed
+- the gates that aren't connected, directly or through other gates, to any output of the circuit
+The gates of the input and output layers are never removed, and the layers left empty are deleted.
+
+Syntaxes:
+1) "optimize"
+2) "optimize -f <filename>"
+The number of gates before and after the optimization is printed on the screen, together with the number
+of gates removed for each reason. With syntax 2, the gates removed are also listed in the specified file,
+one per line, with the syntax
+<gate uid> <constant/wire/dead>)foobar";
+
+const std::string sweep_help =
+R"foobar("sweep" command.
+This command finds the gates whose output is always equal to the output of another gate, or to its
+inverse, and connects the gates they were connected to directly to that gate, taking its inverted output
+if needed. The gates left without connections to any output are then removed, like by "optimize".
+The candidate gates are found by simulating random input vectors, and every candidate is merged only
+after proving that it's equivalent for all the combinations of the inputs, with binary decision diagrams
+or, if they grow too large, by simulating all the combinations of the inputs the two gates depend on or
+with a SAT solver. The input vectors for which the SAT solver finds two candidates to differ are added
+to the simulation, to refute the other candidates of the same class without calling the solver again.
+The candidates the SAT solver gives up on are left unresolved, and kept in the circuit.
+The output buffers are never removed.
+
+Syntaxes:
+1) "sweep"
+2) "sweep -s <seed>"
+3) "sweep -f <filename>"
+The options of syntaxes 2 and 3 can be combined. The seed of the random vectors is 0 by default.
+The number of candidate equivalences proven, refuted and left unresolved is printed on the screen,
+followed by the number of gates before and after the sweep. With "-f" the gates removed are also listed
+in the specified file, one per line, with the syntaxes
+<gate uid> equivalent <uid of the gate it was merged with>
+<gate uid> inverse <uid of the gate whose inverted output it was merged with>
+<gate uid> dead)foobar";
+
+const std::string aig_help =
+R"foobar("aig" command.
+This command converts the circuit to an and-inverter graph, i.e. a circuit made only of AND gates, whose
+inputs can take the inverted outputs of the gates they're connected to. Identical AND gates are merged,
+the gates which don't reach any output are dropped, and every gate is placed in the layer equal to the
+length of the longest path from the inputs to it. The inputs and the output buffers are kept.
+With "-r" the graph is minimized before replacing the circuit, by repeatedly rewriting small portions
+of it (with up to 4 inputs) with cheaper equivalent ones, as long as the number of gates decreases.
+
+Syntaxes:
+1) "aig"
+2) "aig -r"
+The number of AND gates and of layers of the graph are printed on the screen, before and after the
+rewriting, followed by the number of gates of the circuit before and after the conversion (not counting
+the inputs and the output buffers).)foobar";
+
 const std::string gtt_help =
 R"foobar("gtt" command.
 This command simulates the circuit over and over to generate a complete truth table.
 
-Syntax: "gtt"
+Syntaxes:
+1) "gtt"
+2) "gtt -j <num_threads>"
+3) "gtt -g"
+4) "gtt -b <filename>"
+5) "gtt -b <filename> -j <num_threads>"
 The truth table is printed on the screen with the following syntax:
 <inputs> | <corresponding outputs>
 <inputs> | <corresponding outputs>
 <inputs> | <corresponding outputs>
-...)foobar";
+...
+With syntax 2 the combinations of the inputs are split in blocks that are simulated by "num_threads"
+threads at once. The truth table printed is the same, in the same order, whatever the number of threads.
+No more threads are used than the processor can run at once, nor than the blocks (65536 combinations
+each), and the threads are kept for the next commands.
+With syntax 3 the combinations of the inputs are enumerated in Gray-code order, so that only one input
+changes from a combination to the next, and only the gates affected by that input are simulated again.
+The truth table is then reordered, so that it's printed the same as with the other syntaxes.
+This is faster on deep circuits where every input reaches only a small part of the gates.
+With syntaxes 4 and 5 the truth table is written in the specified file in a binary format, instead of
+being printed: for every output only one bit is stored for each combination of the inputs, so the file
+is much smaller than the text and much faster to write. Use "qtt" to read it.)foobar";
+
+const std::string qtt_help =
+R"foobar("qtt" command.
+This command reads a truth table written in the binary format by "gtt -b".
+
+Syntaxes:
+1) "qtt <filename>"
+2) "qtt <filename> <in0 0/1><in1 0/1><in2 0/1>..."
+With syntax 1 the number of inputs and outputs of the truth table are printed, together with the
+number of combinations of the inputs for which every output is 1.
+With syntax 2 the outputs corresponding to the specified inputs are printed, like "ro" does. The inputs
+are written like the argument of "si".
+The file isn't loaded in memory, so this works even for truth tables bigger than the memory.)foobar";
+
+const std::string sk_help =
+R"foobar("sk" command.
+This command selects the kernel used by the bit-parallel simulation engine, which simulates many
+input vectors at once (64 for every 64 bit word carried by a net).
+
+Syntaxes:
+1) "sk"
+2) "sk <kernel>"
+With syntax 1 the kernel in use and the kernels supported by the CPU are printed on screen.
+With syntax 2 the specified kernel is forced. The recognised kernels (case insensitive) are:
+"auto", "scalar", "sse2", "avx2", "avx512".
+"auto" selects the widest kernel supported by the CPU, detected when the program starts.
+
+NOTE: all the kernels compute the same results, forcing one is only useful for benchmarking.)foobar";
+
+const std::string nc_help =
+R"foobar("nc" command.
+This command compiles the circuit to native code, to remove all the overhead of interpreting it.
+The circuit is translated to C++, with one statement for each gate, that is then built by the compiler
+installed on the machine (the one in the CXX environment variable, or "c++") and loaded by the simulator.
+From then on all the simulations use the native code, until the circuit is edited.
+
+Syntaxes:
+1) "nc"
+2) "nc <use_native 0/1>"
+Syntax 1 is the same as syntax 2 with "use_native" set to 1.
+With "use_native" set to 0 the native code is discarded and the simulations go back to the interpreter.
+
+NOTE: building the native code of a big circuit can take a long time, it's worth it only for circuits that
+are simulated a lot of times without being changed.
+NOTE: if no compiler is found, the interpreter keeps being used.
+NOTE: CXX is run directly, not by a shell: it's split on the spaces in the compiler and its first
+arguments (e.g. "ccache g++"), and it can't contain quotes or other shell syntax.)foobar";
+
+const std::string ed_help =
+R"foobar("ed" command.
+This command enables or disables the event-driven simulation.
+In event-driven mode, only the gates reading the inputs that changed since the last simulation are
+updated, then only the gates reading the outputs of those that changed, and so on. The propagation stops
+at the gates whose output doesn't change.
+When consecutive inputs differ in a few bits, this is much faster than simulating the whole circuit.
+
+Syntaxes:
+1) "ed"
+2) "ed <event_driven 0/1>"
+With syntax 1 the current mode is printed on screen.
+
+NOTE: the first simulation after the circuit has been edited always updates the whole circuit.
+NOTE: the event-driven mode doesn't apply while the circuit is compiled to native code (see "nc").)foobar";
 
 const std::string pc_help =
 R"foobar("pc" command.
@@ -326,7 +613,11 @@ This command saves the circuit on a file.
 Syntax: "vc <filename>"
 The filename is a string.
 
-Note: the file saved by the program is a text file. It can be viewed but should NOT be modified.)foobar";
+If the filename ends with ".cbin", the circuit is saved in a compact binary format, which is
+much faster to load than the text one, but can't be read nor edited by hand. The binary
+files can only be loaded by the same version of the program, on the same kind of machine.
+
+Note: otherwise the file saved by the program is a text file. It can be viewed but should NOT be modified.)foobar";
 
 const std::string lc_help =
 R"foobar("lc" command.
@@ -335,6 +626,20 @@ This command loads a circuit from file.
 Syntax: "lc <filename>"
 The filename is a string.
 
+If the filename ends with ".cbin", the file is read in the binary format saved by "vc" (see
+"help vc"). It's checked against a checksum and for consistency before it's loaded.
+
+If the filename ends with ".bench", the file is imported as a netlist in the ISCAS-85/89 .bench
+format, with the lines "INPUT(net)", "OUTPUT(net)" and "net = TYPE(net, net, ...)", where TYPE is
+one of BUF (or BUFF), NOT, AND, NAND, OR, NOR, XOR, XNOR and DFF. The gates with more than two
+inputs are split into trees of 2-input gates, and the gates are placed in layers automatically.
+The flip-flops are cut: the output of every DFF becomes an input of the circuit (after the ones
+declared by INPUT) and its input becomes an output (after the ones declared by OUTPUT), in the
+order the DFFs appear in the file. Circuits can't be saved in this format.
+
+If the file isn't valid, the current circuit is kept. For the text and .bench files, the line
+and column of the first error found are printed on the screen.
+
 Note: the file saved by the program is a text file. It can be viewed but should NOT be modified.)foobar";
 
 const std::string gate_help =
@@ -360,10 +665,16 @@ Each gate has a normal output, and an inverted output. When the gate gets update
 get updated. This effectively makes NAND, NOR and NXOR gates redundant, but it has been decided
 to add this feature because it was easy to implement and to save a few NOT gates here and there.
 
-Each gate has a method, internally, called "calc_output".
-In this method, depending on the gate type, the input connections are checked and if they're valid,
-again, depending on the gate type, the output gets computed and stored.
-If anything goes wrong during this process, the method returns 1, otherwise it returns 0.)foobar";
+Internally, all the gates of the circuit are stored in a single array of small records, holding the type
+of the gate, the indices in the array of the gates connected to its inputs and whether their inverted outputs
+are taken. Every layer lists the indices of its gates, sorted by uid, and a hash table finds the index of the
+gate with a given uid, so the uids are only used to talk with the user. Every gate also lists the inputs
+connected to its output, so that connections are added and deleted without searching the whole circuit.
+
+Before being simulated, each gate is "compiled" in a small record, internally called "gate_op",
+which contains the operation to perform, the indices of the nets read by the two inputs (and whether
+they're inverted) and the index of the net driven by the output.
+If the input connections of a gate aren't valid, the compilation, and so the simulation, fails.)foobar";
 
 const std::string circuit_help =
 R"foobar(This help will talk about how the circuit is structured internally and how it's simulated.
@@ -426,12 +737,13 @@ The circuit simulation is composed of 3 steps:
 - reading the ouputs of the circuit, with the "ro" command
 The first and second steps can also be combined in one by using a special syntax of the "sc" command.
 What happens is:
-- in step 1 the specified inputs are stored in the member "m_inputs" of the "circuit" class, then the contents of
-  m_inputs are split in the buffers of the input layer.
-- in step 2 the simulation goes through each gate of each layer, and computes its output, all the way to the output
-  layer.
+- in step 1 the specified inputs are stored in the member "m_inputs" of the "circuit" class.
+- in step 2, if the circuit has been edited since the last simulation, it gets compiled: the layers are flattened in
+  a contiguous array of gates, sorted by layer, where each gate reads and writes its signals by index in a dense
+  array of nets. Then the contents of m_inputs are copied in the nets of the input layer and the array of gates is
+  streamed from start to end, computing the output of each gate, all the way to the output layer.
 - in step 3 the outputs of the buffers in the output layer are assembled in a vector of bool that then gets printed
   on screen.
-If in any of the gates the method "calc_output" fails, the entire simulation fails and an error is printed on screen.)foobar";
+If any of the gates has its inputs not connected, the compilation fails and an error is printed on screen.)foobar";
 
 #endif
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include "kernels.hpp"
+#include "gates.hpp"
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <bit>
+
+using namespace std;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define X86_KERNELS
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+//Generic implementation of the kernels.
+//V is the type of the register: either a plain uint64_t or a GCC vector of uint64_t. The functions here are always
+//inlined in the kernels below, so that they get compiled with the instruction set enabled for each kernel
+
+typedef uint64_t v1u64 __attribute__((vector_size(8)));
+typedef uint64_t v2u64 __attribute__((vector_size(16)));
+typedef uint64_t v4u64 __attribute__((vector_size(32)));
+typedef uint64_t v8u64 __attribute__((vector_size(64)));
+
+enum class op_kind{and_op, or_op, xor_op};
+
+template<typename V, op_kind K>
+__attribute__((always_inline)) static inline void eval_words(const uint64_t* in0, const uint64_t* in1, uint64_t* out, const size_t& words_per_net,
+                                                              const uint64_t& mask_in0, const uint64_t& mask_in1, const uint64_t& mask_out){
+    constexpr size_t words_per_reg = sizeof(V) / sizeof(uint64_t);
+
+    size_t w = 0;
+    for(; w + words_per_reg <= words_per_net; w += words_per_reg){
+        V a, b, r;
+        memcpy(&a, in0 + w, sizeof(V));
+        memcpy(&b, in1 + w, sizeof(V));
+        a ^= mask_in0;
+        b ^= mask_in1;
+
+        if constexpr(K == op_kind::and_op)
+            r = a & b;
+        else if constexpr(K == op_kind::or_op)
+            r = a | b;
+        else
+            r = a ^ b;
+
+        r ^= mask_out;
+        memcpy(out + w, &r, sizeof(V));
+    }
+
+    //Leftover words that don't fill a whole register
+    for(; w < words_per_net; ++w){
+        const uint64_t a = in0[w] ^ mask_in0;
+        const uint64_t b = in1[w] ^ mask_in1;
+
+        if constexpr(K == op_kind::and_op)
+            out[w] = (a & b) ^ mask_out;
+        else if constexpr(K == op_kind::or_op)
+            out[w] = (a | b) ^ mask_out;
+        else
+            out[w] = (a ^ b) ^ mask_out;
+    }
+}
+
+template<typename V>
+__attribute__((always_inline)) static inline void run_ops(const gate_op* ops, size_t num_ops, uint64_t* nets, size_t words_per_net){
+    for(const gate_op* op = ops; op != ops + num_ops; ++op){
+        const uint64_t* in0 = nets + op->net_in0 * words_per_net;
+        const uint64_t* in1 = nets + op->net_in1 * words_per_net;
+        uint64_t* out = nets + op->net_out * words_per_net;
+        const uint64_t mask_in0 = (op->inv_in0 ? ~uint64_t(0) : 0);
+        const uint64_t mask_in1 = (op->inv_in1 ? ~uint64_t(0) : 0);
+
+        //Every gate is an AND, OR or XOR, optionally followed by an inversion. Buffers and NOT gates have in1 == in0,
+        //so they're ANDs of the input with itself
+        switch(op->type){
+            case gate_type::buffer:
+            case gate_type::and_gate:
+                eval_words<V, op_kind::and_op>(in0, in1, out, words_per_net, mask_in0, mask_in1, 0);
+                break;
+            case gate_type::not_gate:
+            case gate_type::nand_gate:
+                eval_words<V, op_kind::and_op>(in0, in1, out, words_per_net, mask_in0, mask_in1, ~uint64_t(0));
+                break;
+            case gate_type::or_gate:
+                eval_words<V, op_kind::or_op>(in0, in1, out, words_per_net, mask_in0, mask_in1, 0);
+                break;
+            case gate_type::nor_gate:
+                eval_words<V, op_kind::or_op>(in0, in1, out, words_per_net, mask_in0, mask_in1, ~uint64_t(0));
+                break;
+            case gate_type::xor_gate:
+                eval_words<V, op_kind::xor_op>(in0, in1, out, words_per_net, mask_in0, mask_in1, 0);
+                break;
+            case gate_type::nxor_gate:
+                eval_words<V, op_kind::xor_op>(in0, in1, out, words_per_net, mask_in0, mask_in1, ~uint64_t(0));
+                break;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//Kernels
+
+static void run_ops_scalar(const gate_op* ops, size_t num_ops, uint64_t* nets, size_t words_per_net){
+    run_ops<v1u64>(ops, num_ops, nets, words_per_net);
+}
+
+#ifdef X86_KERNELS
+__attribute__((target("sse2")))
+static void run_ops_sse2(const gate_op* ops, size_t num_ops, uint64_t* nets, size_t words_per_net){
+    run_ops<v2u64>(ops, num_ops, nets, words_per_net);
+}
+
+__attribute__((target("avx2")))
+static void run_ops_avx2(const gate_op* ops, size_t num_ops, uint64_t* nets, size_t words_per_net){
+    run_ops<v4u64>(ops, num_ops, nets, words_per_net);
+}
+
+__attribute__((target("avx512f")))
+static void run_ops_avx512(const gate_op* ops, size_t num_ops, uint64_t* nets, size_t words_per_net){
+    run_ops<v8u64>(ops, num_ops, nets, words_per_net);
+}
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+//Counting kernels
+
+__attribute__((always_inline)) static inline void count_ones(const uint64_t* nets, size_t num_nets, size_t words_per_net, const uint64_t* lane_masks, uint64_t* counts){
+    for(size_t net = 0; net < num_nets; ++net){
+        const uint64_t* values = nets + net * words_per_net;
+        uint64_t count = 0;
+        for(size_t w = 0; w < words_per_net; ++w)
+            count += popcount(values[w] & lane_masks[w]);
+        counts[net] += count;
+    }
+}
+
+//Every lane is compared with the previous one: lane 0 of a word with lane 63 of the previous word, and lane 0 of the
+//first word with the last lane of the previous call, which is kept in last_lanes
+__attribute__((always_inline)) static inline void count_toggles(const uint64_t* nets, size_t num_nets, size_t words_per_net, const uint64_t* lane_masks, uint64_t* last_lanes, uint64_t* counts){
+    for(size_t net = 0; net < num_nets; ++net){
+        const uint64_t* values = nets + net * words_per_net;
+        uint64_t previous_lane = last_lanes[net];
+        uint64_t count = 0;
+        for(size_t w = 0; w < words_per_net; ++w){
+            const uint64_t previous_values = (values[w] << 1) | previous_lane;
+            count += popcount((values[w] ^ previous_values) & lane_masks[w]);
+            previous_lane = values[w] >> 63;
+        }
+        last_lanes[net] = previous_lane;
+        counts[net] += count;
+    }
+}
+
+static void count_ones_generic(const uint64_t* nets, size_t num_nets, size_t words_per_net, const uint64_t* lane_masks, uint64_t* counts){
+    count_ones(nets, num_nets, words_per_net, lane_masks, counts);
+}
+
+static void count_toggles_generic(const uint64_t* nets, size_t num_nets, size_t words_per_net, const uint64_t* lane_masks, uint64_t* last_lanes, uint64_t* counts){
+    count_toggles(nets, num_nets, words_per_net, lane_masks, last_lanes, counts);
+}
+
+#ifdef X86_KERNELS
+__attribute__((target("popcnt")))
+static void count_ones_popcnt(const uint64_t* nets, size_t num_nets, size_t words_per_net, const uint64_t* lane_masks, uint64_t* counts){
+    count_ones(nets, num_nets, words_per_net, lane_masks, counts);
+}
+
+__attribute__((target("popcnt")))
+static void count_toggles_popcnt(const uint64_t* nets, size_t num_nets, size_t words_per_net, const uint64_t* lane_masks, uint64_t* last_lanes, uint64_t* counts){
+    count_toggles(nets, num_nets, words_per_net, lane_masks, last_lanes, counts);
+}
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+//Kernel selection
+
+//Function to check if the CPU we're running on can execute the specified kernel
+bool kernel_supported(const sim_kernel& k){
+    switch(k){
+        case sim_kernel::automatic:
+        case sim_kernel::scalar:
+            return true;
+#ifdef X86_KERNELS
+        case sim_kernel::sse2:
+            return __builtin_cpu_supports("sse2");
+        case sim_kernel::avx2:
+            return __builtin_cpu_supports("avx2");
+        case sim_kernel::avx512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+//Function returning the widest kernel supported by the CPU. The detection is done only once, at startup
+sim_kernel best_kernel(){
+    static const sim_kernel detected = [](){
+        for(const auto& k : {sim_kernel::avx512, sim_kernel::avx2, sim_kernel::sse2}){
+            if(kernel_supported(k))
+                return k;
+        }
+        return sim_kernel::scalar;
+    }();
+
+    return detected;
+}
+
+//Function returning the kernel to call. Unsupported kernels fall back to the scalar one
+kernel_fn get_kernel(const sim_kernel& k){
+    if(!kernel_supported(k))
+        return run_ops_scalar;
+
+    switch(k == sim_kernel::automatic ? best_kernel() : k){
+#ifdef X86_KERNELS
+        case sim_kernel::sse2:
+            return run_ops_sse2;
+        case sim_kernel::avx2:
+            return run_ops_avx2;
+        case sim_kernel::avx512:
+            return run_ops_avx512;
+#endif
+        default:
+            return run_ops_scalar;
+    }
+}
+
+//Function returning the kernel counting the ones of the nets: with the popcnt instruction if the CPU supports it,
+//since the generic popcount is much slower
+count_fn get_count_kernel(){
+#ifdef X86_KERNELS
+    if(__builtin_cpu_supports("popcnt"))
+        return count_ones_popcnt;
+#endif
+
+    return count_ones_generic;
+}
+
+//Function returning the kernel counting the toggles of the nets, like get_count_kernel
+toggle_count_fn get_toggle_count_kernel(){
+#ifdef X86_KERNELS
+    if(__builtin_cpu_supports("popcnt"))
+        return count_toggles_popcnt;
+#endif
+
+    return count_toggles_generic;
+}
+
+//Function to convert the kernel to a string
+string kernel_to_str(const sim_kernel& k){
+    switch(k){
+        case sim_kernel::automatic:
+            return "auto";
+        case sim_kernel::scalar:
+            return "scalar";
+        case sim_kernel::sse2:
+            return "sse2";
+        case sim_kernel::avx2:
+            return "avx2";
+        case sim_kernel::avx512:
+            return "avx512";
+    }
+
+    return "";
+}
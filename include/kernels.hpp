@@ -0,0 +1,35 @@
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "gates.hpp"
+
+//----------------------------------------------------------------------------------------------------------------------
+//Kernels that stream an array of gate_ops over nets that carry multiple 64 bit words each.
+//The nets are stored one after the other, net i occupying words [i * words_per_net, (i + 1) * words_per_net).
+//Every kernel computes the same result, they only differ in the width of the registers they use.
+enum class sim_kernel{automatic, scalar, sse2, avx2, avx512};
+
+typedef void (*kernel_fn)(const gate_op* ops, size_t num_ops, uint64_t* nets, size_t words_per_net);
+
+bool kernel_supported(const sim_kernel& k);
+sim_kernel best_kernel();
+kernel_fn get_kernel(const sim_kernel& k);
+std::string kernel_to_str(const sim_kernel& k);
+
+//Kernel adding to counts[i] the number of bits at 1 in the words of net i, among those selected by lane_masks (one mask
+//for each word of a net), for the first num_nets nets
+typedef void (*count_fn)(const uint64_t* nets, size_t num_nets, size_t words_per_net, const uint64_t* lane_masks, uint64_t* counts);
+
+//Kernel adding to counts[i] the number of times net i changes value from a lane to the next one, among the lanes
+//selected by lane_masks. The lanes are compared in order through all the words of a net, and the first lane with the
+//last lane of the previous call, whose value (0 or 1) is read from last_lanes[i] and then updated
+typedef void (*toggle_count_fn)(const uint64_t* nets, size_t num_nets, size_t words_per_net, const uint64_t* lane_masks, uint64_t* last_lanes, uint64_t* counts);
+
+count_fn get_count_kernel();
+toggle_count_fn get_toggle_count_kernel();
+
+#endif
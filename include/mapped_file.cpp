@@ -0,0 +1,83 @@
+#include "mapped_file.hpp"
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#if __has_include(<sys/mman.h>) && __has_include(<sys/stat.h>) && __has_include(<fcntl.h>) && __has_include(<unistd.h>)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define HAS_MMAP
+#endif
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------------------------
+//Public members
+
+mapped_file::~mapped_file(){
+    close();
+}
+
+//Function to map a whole file in memory, replacing the one mapped before, if any. An empty file is mapped as an empty
+//view (data() is nullptr).
+//Returns 1 if the file can't be opened, 2 if it can't be mapped or read
+int mapped_file::open(const string& filename){
+    close();
+
+#ifdef HAS_MMAP
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+        return 1;
+
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)){
+        ::close(fd);
+        return 2;
+    }
+
+    if(file_stat.st_size > 0){
+        void* addr = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(addr == MAP_FAILED){
+            ::close(fd);
+            return 2;
+        }
+
+        //The files are usually parsed once from start to end
+        madvise(addr, file_stat.st_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(addr);
+        m_size = file_stat.st_size;
+    }
+
+    //The mapping stays valid after closing the file descriptor
+    ::close(fd);
+#else
+    ifstream file(filename, ios::binary | ios::ate);
+    if(!file.is_open())
+        return 1;
+
+    m_buffer.resize(file.tellg());
+    file.seekg(0);
+    if(!file.read(m_buffer.data(), m_buffer.size()))
+        return 2;
+
+    m_data = (m_buffer.empty() ? nullptr : m_buffer.data());
+    m_size = m_buffer.size();
+#endif
+
+    return 0;
+}
+
+//Function to unmap the file, if any
+void mapped_file::close(){
+#ifdef HAS_MMAP
+    if(m_data != nullptr)
+        munmap(const_cast<char*>(m_data), m_size);
+#endif
+
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,31 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+//----------------------------------------------------------------------------------------------------------------------
+//Read-only view of a whole file, memory-mapped so that it can be parsed in place without copying it.
+//Where mmap isn't available the file is read in a buffer instead, behind the same interface
+class mapped_file{
+    private:
+        const char* m_data;
+        size_t m_size;
+        std::vector<char> m_buffer;
+
+    public:
+        mapped_file() : m_data(nullptr), m_size(0) {};
+        ~mapped_file();
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        int open(const std::string& filename);
+        void close();
+
+        const char* data() const {return m_data;}
+        size_t size() const {return m_size;}
+};
+
+#endif
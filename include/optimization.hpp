@@ -0,0 +1,48 @@
+#ifndef OPTIMIZATION_HPP
+#define OPTIMIZATION_HPP
+
+#include <vector>
+#include <cstddef>
+
+#define SWEEP_WORDS_PER_NET 16                      //Words of random input vectors in the signature of every net
+#define SWEEP_MAX_BDD_NODES (1 << 18)               //Nodes after which the equivalences are only proven by simulation
+#define SWEEP_MAX_EXHAUSTIVE_INPUTS 16              //Inputs in the support of two nets to compare them exhaustively
+#define SWEEP_SAT_MAX_CONFLICTS 1000                //Conflicts after which an equivalence is left unresolved
+#define SWEEP_SAT_MAX_VARS 20000                    //Variables after which the SAT solver is started over
+#define SWEEP_MAX_CHECKS_PER_NET 4                  //Candidates of the same class a net is compared with
+
+//----------------------------------------------------------------------------------------------------------------------
+//Result of an optimization pass over the circuit: the uids of the gates removed, by the reason they were removed, and
+//the number of gates outside the input and output layers before and after the pass
+struct optimization_report{
+    std::vector<size_t> constant_gates;         //Gates whose output turned out to be constant
+    std::vector<size_t> wire_gates;             //Gates whose output turned out to be equal to another one, or its inverse
+    std::vector<size_t> dead_gates;             //Gates that don't drive any output of the circuit
+    size_t num_gates_before = 0;
+    size_t num_gates_after = 0;
+
+    size_t num_removed() const {return constant_gates.size() + wire_gates.size() + dead_gates.size();}
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+//Gate whose readers have been connected to another gate with the same output, or its inverse, by sweep_equivalent_gates
+struct equivalent_gate{
+    size_t uid;
+    size_t uid_equivalent;
+    bool inverted;
+};
+
+//Result of an equivalence sweep over the circuit: how many candidate equivalences, found by random simulation, have
+//been proven, refuted or left unresolved, the gates merged and the gates left without readers by the merges
+struct sweep_report{
+    size_t num_candidate_classes = 0;           //Classes of at least two nets with the same (or inverse) signature
+    size_t num_proven = 0;
+    size_t num_refuted = 0;
+    size_t num_unresolved = 0;                  //Candidates the SAT solver gave up on
+    std::vector<equivalent_gate> merged_gates;
+    std::vector<size_t> dead_gates;
+    size_t num_gates_before = 0;
+    size_t num_gates_after = 0;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef SAMPLING_HPP
+#define SAMPLING_HPP
+
+#include <vector>
+#include <map>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#define SAMPLING_CONFIDENCE_Z 1.959963984540054     //Quantile of the normal distribution for 95% confidence intervals
+
+//----------------------------------------------------------------------------------------------------------------------
+//Result of a simulation over uniformly random input vectors: how many of them put each output, and the output of each
+//gate (indexed by uid), at 1. The probability of being 1 is estimated by the fraction of the samples, with the Wilson
+//score interval as confidence interval, which stays meaningful for probabilities close to 0 or 1
+struct sampling_report{
+    uint64_t num_samples = 0;
+    std::vector<uint64_t> output_ones;
+    std::map<size_t, uint64_t> gate_ones;
+
+    double probability(const uint64_t& ones) const {return num_samples == 0 ? 0.0 : double(ones) / num_samples;}
+
+    void confidence_interval(const uint64_t& ones, double& low, double& high) const {
+        if(num_samples == 0){
+            low = 0.0;
+            high = 1.0;
+            return;
+        }
+
+        const double n = num_samples;
+        const double p = probability(ones);
+        const double z2 = SAMPLING_CONFIDENCE_Z * SAMPLING_CONFIDENCE_Z;
+        const double center = (p + z2 / (2.0 * n)) / (1.0 + z2 / n);
+        const double half_width = SAMPLING_CONFIDENCE_Z * std::sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n)) / (1.0 + z2 / n);
+
+        low = (ones == 0 ? 0.0 : std::max(0.0, center - half_width));
+        high = (ones == num_samples ? 1.0 : std::min(1.0, center + half_width));
+    }
+};
+
+#endif
@@ -0,0 +1,345 @@
+#include "sat.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+//The reason of the variables decided, or assigned by a unit clause
+static const uint32_t NO_REASON = UINT32_MAX;
+//The position in the heap of the variables which aren't in it
+static const uint32_t NOT_IN_HEAP = UINT32_MAX;
+
+//----------------------------------------------------------------------------------------------------------------------
+//Private members
+
+//Function to set a literal to true at the current decision level, implied by the specified clause
+void sat_solver::assign(const uint32_t& lit, const uint32_t& reason){
+    const uint32_t var = lit >> 1;
+    m_values[var] = 1 ^ (lit & 1);
+    m_levels[var] = decision_level();
+    m_reasons[var] = reason;
+    m_trail.push_back(lit);
+}
+
+//Function to assign all the literals implied by the literals of the trail not propagated yet. For every literal set to
+//false, the clauses watching it look for another literal which isn't false to watch, and if there's none the other
+//watched literal is implied, unless it's false too.
+//Returns the clause all of whose literals are false, if any, otherwise NO_REASON
+uint32_t sat_solver::propagate(){
+    while(m_propagated < m_trail.size()){
+        const uint32_t false_lit = m_trail[m_propagated++] ^ 1;
+        vector<uint32_t>& watching = m_watches[false_lit];
+
+        size_t kept = 0;
+        for(size_t i = 0; i < watching.size(); ++i){
+            const uint32_t c = watching[i];
+            vector<uint32_t>& clause = m_clauses[c];
+            if(clause[0] == false_lit)
+                swap(clause[0], clause[1]);
+
+            if(value(clause[0]) == 1){
+                watching[kept++] = c;
+                continue;
+            }
+
+            bool moved = false;
+            for(size_t k = 2; k < clause.size(); ++k){
+                if(value(clause[k]) != 0){
+                    swap(clause[1], clause[k]);
+                    m_watches[clause[1]].push_back(c);
+                    moved = true;
+                    break;
+                }
+            }
+            if(moved)
+                continue;
+
+            watching[kept++] = c;
+            if(value(clause[0]) == 0){
+                while(++i < watching.size())
+                    watching[kept++] = watching[i];
+                watching.resize(kept);
+                return c;
+            }
+
+            assign(clause[0], c);
+        }
+        watching.resize(kept);
+    }
+
+    return NO_REASON;
+}
+
+//Function to learn a clause from a conflict, resolving the conflicting clause with the reasons of the literals of the
+//current decision level until only one of them is left (the first unique implication point). The learnt clause has
+//that literal first, and the literal of the highest level among the others second, which is the level to backtrack to
+void sat_solver::analyze(const uint32_t& conflict, vector<uint32_t>& learnt, uint32_t& backtrack_level){
+    learnt.assign(1, 0);
+
+    size_t pending = 0;
+    size_t trail_index = m_trail.size();
+    uint32_t implied_lit = 0;
+    uint32_t c = conflict;
+    bool first_clause = true;
+
+    do {
+        const vector<uint32_t>& clause = m_clauses[c];
+        for(size_t i = (first_clause ? 0 : 1); i < clause.size(); ++i){
+            const uint32_t var = clause[i] >> 1;
+            if(m_seen[var] || m_levels[var] == 0)
+                continue;
+
+            m_seen[var] = true;
+            bump(var);
+            if(m_levels[var] == decision_level())
+                ++pending;
+            else
+                learnt.push_back(clause[i]);
+        }
+        first_clause = false;
+
+        while(!m_seen[m_trail[--trail_index] >> 1]);
+        implied_lit = m_trail[trail_index];
+        c = m_reasons[implied_lit >> 1];
+        m_seen[implied_lit >> 1] = false;
+        --pending;
+    } while(pending > 0);
+
+    learnt[0] = implied_lit ^ 1;
+
+    backtrack_level = 0;
+    for(size_t i = 1; i < learnt.size(); ++i){
+        m_seen[learnt[i] >> 1] = false;
+        if(m_levels[learnt[i] >> 1] > backtrack_level){
+            backtrack_level = m_levels[learnt[i] >> 1];
+            swap(learnt[1], learnt[i]);
+        }
+    }
+}
+
+//Function to unassign all the variables of the levels above the specified one, saving their values as phases
+void sat_solver::backtrack(const uint32_t& level){
+    if(decision_level() <= level)
+        return;
+
+    for(size_t i = m_trail.size(); i-- > m_trail_levels[level];){
+        const uint32_t var = m_trail[i] >> 1;
+        m_phases[var] = m_values[var];
+        m_values[var] = -1;
+        m_reasons[var] = NO_REASON;
+        heap_insert(var);
+    }
+
+    m_trail.resize(m_trail_levels[level]);
+    m_trail_levels.resize(level);
+    m_propagated = m_trail.size();
+}
+
+//Function to increase the activity of a variable involved in a conflict. The increment grows at every conflict, so that
+//the recent conflicts weigh more, and all the activities are scaled down before they overflow
+void sat_solver::bump(const uint32_t& var){
+    m_activities[var] += m_activity_increment;
+
+    if(m_activities[var] > 1e100){
+        for(auto& a : m_activities)
+            a *= 1e-100;
+        m_activity_increment *= 1e-100;
+    }
+
+    if(m_heap_positions[var] != NOT_IN_HEAP)
+        heap_sift_up(m_heap_positions[var]);
+}
+
+//Function to add a variable to the heap of the unassigned variables, if it isn't there yet
+void sat_solver::heap_insert(const uint32_t& var){
+    if(m_heap_positions[var] != NOT_IN_HEAP)
+        return;
+
+    m_heap_positions[var] = m_heap.size();
+    m_heap.push_back(var);
+    heap_sift_up(m_heap.size() - 1);
+}
+
+//Functions to move a variable of the heap towards the root while it's more active than its parent, or towards the
+//leaves while it's less active than its most active child
+void sat_solver::heap_sift_up(size_t pos){
+    const uint32_t var = m_heap[pos];
+
+    while(pos > 0 && m_activities[m_heap[(pos - 1) / 2]] < m_activities[var]){
+        m_heap[pos] = m_heap[(pos - 1) / 2];
+        m_heap_positions[m_heap[pos]] = pos;
+        pos = (pos - 1) / 2;
+    }
+
+    m_heap[pos] = var;
+    m_heap_positions[var] = pos;
+}
+
+void sat_solver::heap_sift_down(size_t pos){
+    const uint32_t var = m_heap[pos];
+
+    while(2 * pos + 1 < m_heap.size()){
+        size_t child = 2 * pos + 1;
+        if(child + 1 < m_heap.size() && m_activities[m_heap[child + 1]] > m_activities[m_heap[child]])
+            ++child;
+        if(m_activities[m_heap[child]] <= m_activities[var])
+            break;
+
+        m_heap[pos] = m_heap[child];
+        m_heap_positions[m_heap[pos]] = pos;
+        pos = child;
+    }
+
+    m_heap[pos] = var;
+    m_heap_positions[var] = pos;
+}
+
+//Function to start watching the first two literals of a clause
+void sat_solver::attach(const uint32_t& clause){
+    m_watches[m_clauses[clause][0]].push_back(clause);
+    m_watches[m_clauses[clause][1]].push_back(clause);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//Public members
+
+sat_solver::sat_solver() :
+    m_propagated(0),
+    m_activity_increment(1.0),
+    m_inconsistent(false)
+{}
+
+//Function to add a new variable, returning its index
+uint32_t sat_solver::new_var(){
+    const uint32_t var = m_values.size();
+
+    m_values.push_back(-1);
+    m_phases.push_back(0);
+    m_levels.push_back(0);
+    m_reasons.push_back(NO_REASON);
+    m_activities.push_back(0.0);
+    m_seen.push_back(false);
+    m_watches.emplace_back();
+    m_watches.emplace_back();
+    m_heap_positions.push_back(NOT_IN_HEAP);
+    heap_insert(var);
+
+    return var;
+}
+
+//Function to add a clause, the disjunction of the specified literals. The clauses with both a literal and its negation
+//are dropped, and the unit clauses are assigned right away
+void sat_solver::add_clause(vector<uint32_t> lits){
+    backtrack(0);
+    if(m_inconsistent)
+        return;
+
+    sort(lits.begin(), lits.end());
+    lits.erase(unique(lits.begin(), lits.end()), lits.end());
+
+    size_t kept = 0;
+    for(size_t i = 0; i < lits.size(); ++i){
+        if(value(lits[i]) == 1 || (i + 1 < lits.size() && lits[i + 1] == (lits[i] ^ 1)))
+            return;
+        if(value(lits[i]) != 0)
+            lits[kept++] = lits[i];
+    }
+    lits.resize(kept);
+
+    if(lits.empty())
+        m_inconsistent = true;
+    else if(lits.size() == 1){
+        assign(lits[0], NO_REASON);
+        if(propagate() != NO_REASON)
+            m_inconsistent = true;
+    }
+    else {
+        m_clauses.push_back(move(lits));
+        attach(m_clauses.size() - 1);
+    }
+}
+
+//Function to search for an assignment of the variables satisfying all the clauses and the assumptions, which is then
+//read with model_value, giving up after max_conflicts conflicts. The result unsatisfiable only holds for the assumptions
+//specified, unless no assumptions are specified
+sat_result sat_solver::solve(const vector<uint32_t>& assumptions, const size_t& max_conflicts){
+    backtrack(0);
+    if(m_inconsistent)
+        return sat_result::unsatisfiable;
+
+    size_t num_conflicts = 0;
+    double restart_conflicts = SAT_FIRST_RESTART;
+    size_t conflicts_since_restart = 0;
+    vector<uint32_t> learnt;
+
+    while(true){
+        const uint32_t conflict = propagate();
+
+        if(conflict != NO_REASON){
+            if(decision_level() == 0){
+                m_inconsistent = true;
+                return sat_result::unsatisfiable;
+            }
+
+            uint32_t backtrack_level;
+            analyze(conflict, learnt, backtrack_level);
+            backtrack(backtrack_level);
+
+            if(learnt.size() == 1)
+                assign(learnt[0], NO_REASON);
+            else {
+                m_clauses.push_back(learnt);
+                attach(m_clauses.size() - 1);
+                assign(learnt[0], m_clauses.size() - 1);
+            }
+
+            m_activity_increment /= SAT_ACTIVITY_DECAY;
+            ++num_conflicts;
+            ++conflicts_since_restart;
+
+            if(num_conflicts >= max_conflicts){
+                backtrack(0);
+                return sat_result::unknown;
+            }
+            if(conflicts_since_restart >= restart_conflicts){
+                backtrack(0);
+                conflicts_since_restart = 0;
+                restart_conflicts *= SAT_RESTART_GROWTH;
+            }
+        }
+        else if(decision_level() < assumptions.size()){
+            //Every assumption gets its own decision level, even if it's already true
+            const uint32_t lit = assumptions[decision_level()];
+            if(value(lit) == 0){
+                backtrack(0);
+                return sat_result::unsatisfiable;
+            }
+
+            m_trail_levels.push_back(m_trail.size());
+            if(value(lit) < 0)
+                assign(lit, NO_REASON);
+        }
+        else {
+            //The variables assigned by propagation are left in the heap, and skipped here
+            uint32_t var = NOT_IN_HEAP;
+            while(!m_heap.empty() && var == NOT_IN_HEAP){
+                const uint32_t top = m_heap[0];
+                m_heap_positions[top] = NOT_IN_HEAP;
+                m_heap[0] = m_heap.back();
+                m_heap.pop_back();
+                if(!m_heap.empty())
+                    heap_sift_down(0);
+
+                if(m_values[top] < 0)
+                    var = top;
+            }
+            if(var == NOT_IN_HEAP)
+                return sat_result::satisfiable;
+
+            m_trail_levels.push_back(m_trail.size());
+            assign(2 * var + (m_phases[var] ? 0 : 1), NO_REASON);
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef SAT_HPP
+#define SAT_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#define SAT_FIRST_RESTART 100                       //Conflicts before the first restart, then growing geometrically
+#define SAT_RESTART_GROWTH 1.5
+#define SAT_ACTIVITY_DECAY 0.95                     //Factor the activity of the variables decays by at every conflict
+
+enum class sat_result{satisfiable, unsatisfiable, unknown};
+
+//----------------------------------------------------------------------------------------------------------------------
+//Conflict-driven clause learning SAT solver, for the small instances built to prove the equivalence of two signals.
+//Literals are encoded like in the and-inverter graphs: literal 2 * v is variable v and literal 2 * v + 1 is its
+//negation. Every clause watches its first two literals, the clauses learnt from the conflicts (with the first unique
+//implication point) are never deleted, the decisions follow the most active variable with its last value, and the
+//search restarts after a geometrically growing number of conflicts.
+//The solver is incremental: clauses can be added between the calls to solve, and every call can assume some literals
+//to be true, which are the first decisions, so that the clauses learnt never depend on them
+class sat_solver{
+    private:
+        std::vector<std::vector<uint32_t>> m_clauses;
+        std::vector<std::vector<uint32_t>> m_watches;           //Clauses watching each literal
+        std::vector<int8_t> m_values;                           //Value of each variable, -1 if unassigned
+        std::vector<uint8_t> m_phases;                          //Last value of each variable
+        std::vector<uint32_t> m_levels;
+        std::vector<uint32_t> m_reasons;                        //Clause that implied each variable, NO_REASON if decided
+        std::vector<double> m_activities;
+        std::vector<uint8_t> m_seen;                            //Used by analyze
+        std::vector<uint32_t> m_heap;                           //Unassigned variables, as a binary heap by activity
+        std::vector<uint32_t> m_heap_positions;                 //Position of each variable in the heap, if it's there
+        std::vector<uint32_t> m_trail;
+        std::vector<size_t> m_trail_levels;                     //Position in the trail of the first literal of each level
+        size_t m_propagated;
+        double m_activity_increment;
+        bool m_inconsistent;                                    //Set when a clause is empty at level 0
+
+        int8_t value(const uint32_t& lit) const {return m_values[lit >> 1] < 0 ? -1 : m_values[lit >> 1] ^ (lit & 1);}
+        uint32_t decision_level() const {return m_trail_levels.size();}
+
+        void assign(const uint32_t& lit, const uint32_t& reason);
+        uint32_t propagate();
+        void analyze(const uint32_t& conflict, std::vector<uint32_t>& learnt, uint32_t& backtrack_level);
+        void backtrack(const uint32_t& level);
+        void bump(const uint32_t& var);
+        void heap_insert(const uint32_t& var);
+        void heap_sift_up(size_t pos);
+        void heap_sift_down(size_t pos);
+        void attach(const uint32_t& clause);
+
+    public:
+        sat_solver();
+
+        uint32_t new_var();
+        size_t num_vars() const {return m_values.size();}
+        void add_clause(std::vector<uint32_t> lits);
+        sat_result solve(const std::vector<uint32_t>& assumptions, const size_t& max_conflicts);
+        bool model_value(const uint32_t& var) const {return m_values[var] == 1;}
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef TESTABILITY_HPP
+#define TESTABILITY_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+#define SCOAP_INFINITY (uint64_t(1) << 48)          //Cost of setting or observing a value that can't be set or observed
+
+//----------------------------------------------------------------------------------------------------------------------
+//Testability measures of the output of a gate, computed without simulating any vector.
+//cc0, cc1 and co are the SCOAP combinational controllabilities to 0 and 1 and the combinational observability: roughly,
+//the number of gates that have to be set to put the output at 0 or 1, or to propagate it to an output of the circuit.
+//p1 and obs are the COP signal probability (the probability of the output being 1 with uniformly random inputs) and
+//the probability of the output being observed at an output of the circuit, assuming that all signals are independent
+struct gate_testability{
+    uint64_t cc0;
+    uint64_t cc1;
+    uint64_t co;
+    double p1;
+    double obs;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "thread_pool.hpp"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+using namespace std;
+
+//Function to choose the number of workers of a parallel job, from the number of threads requested: at least 1, and no
+//more than the hardware threads nor the tasks the job can be split in, since the others would have nothing to do
+size_t pool_workers(const size_t& num_threads, const uint64_t& num_tasks){
+    uint64_t num_workers = min<uint64_t>(num_threads, num_tasks);
+
+    //hardware_concurrency is 0 if it isn't known
+    const unsigned int hardware_threads = thread::hardware_concurrency();
+    if(hardware_threads > 0)
+        num_workers = min<uint64_t>(num_workers, hardware_threads);
+
+    return max<uint64_t>(num_workers, 1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//Private members
+
+//Function executed by the threads of the pool, each of them being the worker index of the jobs. The generation is the
+//one of the last job started before the thread, which it must not run
+void thread_pool::worker(const size_t& index, uint64_t generation){
+    unique_lock<mutex> lock(m_mutex);
+
+    while(true){
+        m_job_ready.wait(lock, [&](){return m_stopping || m_generation != generation;});
+        if(m_stopping)
+            break;
+        generation = m_generation;
+
+        //The threads beyond the workers of the job just wait for the next one
+        if(index >= m_num_workers)
+            continue;
+
+        lock.unlock();
+        (*m_job)(index);
+        lock.lock();
+
+        if(--m_running == 0)
+            m_job_done.notify_one();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//Public members
+
+thread_pool::thread_pool() :
+    m_job(nullptr),
+    m_num_workers(0),
+    m_running(0),
+    m_generation(0),
+    m_stopping(false)
+{}
+
+thread_pool::~thread_pool(){
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_job_ready.notify_all();
+
+    for(auto& t : m_threads)
+        t.join();
+}
+
+//Function to run a job on num_workers workers, starting the threads missing, and wait for all of them to finish it.
+//With a single worker, the job is run by the calling thread without involving the pool
+void thread_pool::run(const size_t& num_workers, const function<void(const size_t&)>& job){
+    if(num_workers <= 1){
+        job(0);
+        return;
+    }
+
+    lock_guard<mutex> run_lock(m_run_mutex);
+
+    //Only run changes the generation, and run_lock is held, so it can be read without locking m_mutex
+    while(m_threads.size() + 1 < num_workers)
+        m_threads.emplace_back(&thread_pool::worker, this, m_threads.size() + 1, m_generation);
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_job = &job;
+        m_num_workers = num_workers;
+        m_running = num_workers - 1;
+        ++m_generation;
+    }
+    m_job_ready.notify_all();
+
+    job(0);
+
+    unique_lock<mutex> lock(m_mutex);
+    m_job_done.wait(lock, [this](){return m_running == 0;});
+    m_job = nullptr;
+}
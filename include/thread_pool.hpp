@@ -0,0 +1,46 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+size_t pool_workers(const size_t& num_threads, const uint64_t& num_tasks);
+
+//----------------------------------------------------------------------------------------------------------------------
+//Pool of threads started on the first job that needs them and kept until the pool is destroyed, so that the parallel
+//jobs don't pay for starting and joining threads every time.
+//A job is a function called once by each of the workers, with the index of the worker: the worker 0 is the thread
+//calling run, which returns when all of them are done. The workers can wait for each other inside the job (e.g. with a
+//std::barrier), since they all run at once. The jobs are run one at a time, and a job must not run another one.
+//The threads aren't part of the state of the object owning the pool, so copying a pool gives one without threads
+class thread_pool{
+    private:
+        std::vector<std::thread> m_threads;
+        std::mutex m_run_mutex;                                 //Held by run, so that only one job uses the threads
+        std::mutex m_mutex;
+        std::condition_variable m_job_ready;
+        std::condition_variable m_job_done;
+        const std::function<void(const size_t&)>* m_job;
+        size_t m_num_workers;                                   //Workers of the current job, including the worker 0
+        size_t m_running;                                       //Threads still running the current job
+        uint64_t m_generation;                                  //Number of jobs started, to wake up the threads once
+        bool m_stopping;
+
+        void worker(const size_t& index, uint64_t generation);
+
+    public:
+        thread_pool();
+        ~thread_pool();
+
+        thread_pool(const thread_pool&) : thread_pool() {}
+        thread_pool& operator=(const thread_pool&) {return *this;}
+
+        void run(const size_t& num_workers, const std::function<void(const size_t&)>& job);
+};
+
+#endif
@@ -0,0 +1,94 @@
+#include "truth_table.hpp"
+#include "mapped_file.hpp"
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <bit>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------------------------
+//Private members
+
+//Function to read the word of the column of an output which contains the specified row
+uint64_t packed_truth_table::column_word(const uint64_t& row, const size_t& output) const {
+    const uint64_t block = row / m_header.rows_per_block;
+    const uint64_t word = (block * m_header.num_outputs + output) * m_words_per_column + (row % m_header.rows_per_block) / 64;
+
+    //The words are copied, since they aren't guaranteed to be aligned if the file couldn't be mapped
+    uint64_t value;
+    memcpy(&value, m_file.data() + sizeof(packed_truth_table_header) + word * sizeof(uint64_t), sizeof(uint64_t));
+    return value;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//Public members
+
+//Function to open a truth table written in the binary format.
+//Returns 1 if the file can't be opened, 2 if it isn't a truth table in the binary format, 3 if it has been written by an
+//unsupported version of the format and 4 if it's truncated or its header is inconsistent
+int packed_truth_table::open(const string& filename){
+    m_header = packed_truth_table_header{};
+    m_words_per_column = 0;
+
+    if(m_file.open(filename) != 0)
+        return 1;
+
+    if(m_file.size() < sizeof(packed_truth_table_header))
+        return 2;
+
+    packed_truth_table_header header;
+    memcpy(&header, m_file.data(), sizeof(header));
+    if(memcmp(header.magic, PACKED_TRUTH_TABLE_MAGIC, sizeof(header.magic)) != 0)
+        return 2;
+
+    if(header.version != PACKED_TRUTH_TABLE_VERSION)
+        return 3;
+
+    //The blocks of less than 64 rows would share the words of their columns, so they're only allowed if there's one
+    const uint64_t num_rows = (header.num_inputs < 64 ? uint64_t(1) << header.num_inputs : 0);
+    if(header.num_inputs >= 64 || header.rows_per_block == 0 || !has_single_bit(header.rows_per_block) ||
+       header.rows_per_block > num_rows || (header.rows_per_block < 64 && header.rows_per_block != num_rows))
+        return 4;
+
+    //Each factor of the size of the rows is checked against the size of the file before multiplying, so that the
+    //product can't overflow
+    const uint64_t num_blocks = num_rows / header.rows_per_block;
+    const uint64_t words_per_column = (header.rows_per_block + 63) / 64;
+    const uint64_t file_words = (m_file.size() - sizeof(header)) / sizeof(uint64_t);
+    if(header.num_outputs > 0 && (num_blocks > file_words / header.num_outputs ||
+                                  words_per_column > file_words / (num_blocks * header.num_outputs)))
+        return 4;
+
+    if(m_file.size() != sizeof(header) + num_blocks * header.num_outputs * words_per_column * sizeof(uint64_t))
+        return 4;
+
+    m_header = header;
+    m_words_per_column = words_per_column;
+
+    return 0;
+}
+
+//Function to read the value of an output in a row of the truth table. The row and the output must exist
+bool packed_truth_table::read_output(const uint64_t& row, const size_t& output) const {
+    return (column_word(row, output) >> (row % 64)) & 1;
+}
+
+//Function to read the values of all the outputs in a row of the truth table. The row must exist
+vector<bool> packed_truth_table::read_outputs(const uint64_t& row) const {
+    vector<bool> outputs(m_header.num_outputs);
+    for(size_t j = 0; j < outputs.size(); ++j)
+        outputs[j] = read_output(row, j);
+
+    return outputs;
+}
+
+//Function to count the rows of the truth table in which an output is 1. The output must exist
+uint64_t packed_truth_table::count_ones(const size_t& output) const {
+    uint64_t ones = 0;
+    for(uint64_t row = 0; row < num_rows(); row += 64)
+        ones += popcount(column_word(row, output));
+
+    return ones;
+}
@@ -0,0 +1,52 @@
+#ifndef TRUTH_TABLE_HPP
+#define TRUTH_TABLE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "mapped_file.hpp"
+
+#define PACKED_TRUTH_TABLE_MAGIC "DCSTTBL"          //Followed by the null terminator, it fills the 8 bytes of the magic
+#define PACKED_TRUTH_TABLE_VERSION 1
+
+//----------------------------------------------------------------------------------------------------------------------
+//Binary format of the truth tables written by circuit::gen_truth_table_packed.
+//The header is followed by the rows of the truth table, split in blocks of rows_per_block rows (a power of 2, all of
+//them if they're less than TRUTH_TABLE_ROWS_PER_BLOCK). Every block stores a column of bits for each output, one after
+//the other, in (rows_per_block + 63) / 64 words: bit r % 64 of word r / 64 of the column of output j is the value of
+//output j in row r of the block. Row r of the truth table has input i equal to bit i of r, like in gen_truth_table.
+//Every field is stored in the byte order of the machine that wrote the file
+struct packed_truth_table_header{
+    char magic[8];
+    uint32_t version;
+    uint32_t num_inputs;
+    uint32_t num_outputs;
+    uint32_t rows_per_block;
+};
+
+//Reader of the truth tables in the binary format, memory-mapped so that any row can be queried without loading them
+class packed_truth_table{
+    private:
+        mapped_file m_file;
+        packed_truth_table_header m_header;
+        size_t m_words_per_column;
+
+        uint64_t column_word(const uint64_t& row, const size_t& output) const;
+
+    public:
+        packed_truth_table() : m_header{}, m_words_per_column(0) {};
+
+        int open(const std::string& filename);
+
+        size_t num_inputs() const {return m_header.num_inputs;}
+        size_t num_outputs() const {return m_header.num_outputs;}
+        uint64_t num_rows() const {return uint64_t(1) << m_header.num_inputs;}
+
+        bool read_output(const uint64_t& row, const size_t& output) const;
+        std::vector<bool> read_outputs(const uint64_t& row) const;
+        uint64_t count_ones(const size_t& output) const;
+};
+
+#endif
@@ -9,6 +9,7 @@ git-gabri.
 
 #include "circuit.hpp"
 #include "console.hpp"
+#include "kernels.hpp"
 
 #define CONSOLE_CURSOR "\n> "
 #define DEFAULT_NUM_INPUTS 4
@@ -30,6 +31,7 @@ int main() {
     cout << "Combinational logic circuit simulator by git-gabri" << endl;
     cout << endl;
     cout << "Circuit initialized with " << DEFAULT_NUM_INPUTS << " (+2) inputs and " << DEFAULT_NUM_OUTPUTS << " outputs" << endl;
+    cout << "Bit-parallel simulation kernel: " << kernel_to_str(best_kernel()) << endl;
     cout << "Type \"help\" or \"h\" for help" << endl;
     cout << "Type ";
     for(auto it_exit_cmds = exit_commands.begin(); it_exit_cmds != exit_commands.end(); ++it_exit_cmds){
@@ -47,7 +49,8 @@ int main() {
         cout << CONSOLE_CURSOR;
         getline(cin, user_input);
 
-        should_exit = (find(exit_commands.begin(), exit_commands.end(), user_input) != exit_commands.end());
+        //The input also ends when the standard input is closed, e.g. after "ssf -" has consumed it
+        should_exit = (!cin || find(exit_commands.begin(), exit_commands.end(), user_input) != exit_commands.end());
 
         if(!should_exit){
             con.execute_command(user_input);